@@ -48,8 +48,9 @@ layout(push_constant) uniform Constant
 void main() 
 {
 #ifdef INDIRECT
-    outDrawID = gl_DrawID;
-    PerDrawData drawData = perDrawBuffer.perDrawData[gl_DrawID];
+    // Culled draws are compacted, so the mesh index comes in through firstInstance
+    outDrawID = gl_InstanceIndex;
+    PerDrawData drawData = perDrawBuffer.perDrawData[gl_InstanceIndex];
     Vertex vertex = vertexBuffer.vertices[gl_VertexIndex];
     mat4 model = transformBuffer.transforms[drawData.transformIndex];
 #else
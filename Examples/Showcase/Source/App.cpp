@@ -3,6 +3,9 @@
 #include "Parser.hpp"
 #include "Structs.hpp"
 #include "Swift.hpp"
+#include "SwiftBVH.hpp"
+#include "SwiftOcclusion.hpp"
+#include "SwiftStreaming.hpp"
 #include "SwiftUtil.hpp"
 #include "Window.hpp"
 #include "future"
@@ -25,6 +28,39 @@ int main()
     Swift::ImGUI::Init();
     Parser::Init();
 
+    // ------------------------------Creating all required shaders----------------------------------
+
+    // Compiled in the background while the scene loads, first use waits for them if needed
+    const auto skyboxShader = Swift::CreateGraphicsShaderAsync(
+        "../Shaders/skybox.vert.spv",
+        "../Shaders/skybox.frag.spv",
+        "Skybox Shader");
+
+    const auto graphicsShader = Swift::CreateGraphicsShaderAsync(
+        "../Shaders/model.vert.spv",
+        "../Shaders/model.frag.spv",
+        "Model Shader");
+
+    const auto indirectDrawShader = Swift::CreateGraphicsShaderAsync(
+        "../Shaders/indirect_model.vert.spv",
+        "../Shaders/indirect_model.frag.spv",
+        "Indirect Model Shader");
+
+    const auto indirectFillShader =
+        Swift::CreateComputeShaderAsync("../Shaders/indirect.comp.spv", "Indirect Shader");
+    // The cull shaders compact their output with subgroup ballots where the device has them
+    const std::string cullPrefix = Swift::SupportsSubgroupBallot() ? "" : "atomic_";
+    const auto indirectCullShader = Swift::CreateComputeShaderAsync(
+        "../Shaders/" + cullPrefix + "indirectCull.comp.spv",
+        "Cull Shader");
+    const auto occlusionCullShader = Swift::CreateComputeShaderAsync(
+        "../Shaders/" + cullPrefix + "occlusionCull.comp.spv",
+        "Occlusion Cull Shader");
+    const auto depthReduceShader =
+        Swift::CreateComputeShaderAsync("../Shaders/depthReduce.comp.spv", "Depth Reduce Shader");
+    const auto streamShader =
+        Swift::CreateComputeShaderAsync("../Shaders/stream.comp.spv", "Stream Shader");
+
     // --------------------------Initialising scene data and uploading to GPU-----------------------
 
     auto cameraData = Camera::Init(glm::vec3(0, 0, 2));
@@ -61,12 +97,15 @@ int main()
 
     const auto transformSize = scene.transforms.size() * sizeof(glm::mat4);
     const auto transformBuffer =
-        Swift::CreateBuffer(Swift::BufferType::eStorage, transformSize, "Transform Buffer");
+        Swift::CreateBuffer(Swift::BufferType::eStorage, transformSize, "Transform Buffer", true);
     Swift::UploadToBuffer(transformBuffer, scene.transforms.data(), 0, transformSize);
 
     const auto boundingSize = scene.boundingSpheres.size() * sizeof(Swift::BoundingSphere);
-    const auto boundingBuffer =
-        Swift::CreateBuffer(Swift::BufferType::eStorage, boundingSize, "Bounding Sphere Buffer");
+    const auto boundingBuffer = Swift::CreateBuffer(
+        Swift::BufferType::eStorage,
+        boundingSize,
+        "Bounding Sphere Buffer",
+        true);
     Swift::UploadToBuffer(boundingBuffer, scene.boundingSpheres.data(), 0, boundingSize);
 
     std::vector<Light> lights;
@@ -98,13 +137,37 @@ int main()
 
     // -----------------------------Creating and uploading images in bulk--------------------------
 
-    Swift::BeginTransfer();
+    const auto images = Swift::LoadImagesFromFiles(scene.uris, 0, true);
 
     std::unordered_map<u32, int> textureIndices;
-    for (const auto& [index, uri] : std::views::enumerate(scene.uris))
+    for (const auto& [index, image] : std::views::enumerate(images))
     {
-        const auto image = Swift::LoadImageFromFileQueued(uri, 0, true, uri);
-        textureIndices[index] = static_cast<int>(Swift::GetImageArrayIndex(image));
+        // Textures that failed to load are sampled as if the material had none
+        textureIndices[index] =
+            Swift::IsValid(image) ? static_cast<int>(Swift::GetImageArrayIndex(image)) : -1;
+    }
+
+    // Every texture streams at the resolution its closest mesh asks for
+    std::vector<std::vector<u32>> textureMeshes(images.size());
+    for (const auto& [index, mesh] : std::views::enumerate(scene.meshes))
+    {
+        if (mesh.materialIndex < 0)
+        {
+            continue;
+        }
+        const auto& material = scene.materials[mesh.materialIndex];
+        for (const auto textureIndex :
+             {material.baseTextureIndex,
+              material.metallicRoughnessTextureIndex,
+              material.emissiveTextureIndex,
+              material.normalTextureIndex,
+              material.occlusionTextureIndex})
+        {
+            if (textureIndex != -1)
+            {
+                textureMeshes[textureIndex].emplace_back(static_cast<u32>(index));
+            }
+        }
     }
 
     // Update the material texture indices so that we can index into the texture in the shader
@@ -134,30 +197,6 @@ int main()
     }
     Swift::UploadToBuffer(materialBuffer, scene.materials.data(), 0, materialSize);
 
-    Swift::EndTransfer();
-
-    // ------------------------------Creating all required shaders----------------------------------
-
-    const auto skyboxShader = Swift::CreateGraphicsShader(
-        "../Shaders/skybox.vert.spv",
-        "../Shaders/skybox.frag.spv",
-        "Skybox Shader");
-
-    const auto graphicsShader = Swift::CreateGraphicsShader(
-        "../Shaders/model.vert.spv",
-        "../Shaders/model.frag.spv",
-        "Model Shader");
-
-    const auto indirectDrawShader = Swift::CreateGraphicsShader(
-        "../Shaders/indirect_model.vert.spv",
-        "../Shaders/indirect_model.frag.spv",
-        "Indirect Model Shader");
-
-    const auto indirectFillShader =
-        Swift::CreateComputeShader("../Shaders/indirect.comp.spv", "Indirect Shader");
-    const auto indirectCullShader =
-        Swift::CreateComputeShader("../Shaders/indirectCull.comp.spv", "Cull Shader");
-
     // ---------------------Creating and uploading data for indirect drawing------------------------
 
     const u32 totalMeshes = scene.meshes.size();
@@ -167,10 +206,11 @@ int main()
     perDrawDatas.reserve(totalMeshes);
     std::vector<VkDrawIndexedIndirectCommand> indirectCommands;
     indirectCommands.reserve(totalMeshes);
-    for (auto& mesh : scene.meshes)
+    for (const auto& [index, mesh] : std::views::enumerate(scene.meshes))
     {
+        // The indirect shaders look the per draw data up through firstInstance
         const auto drawIndirectCommand = vk::DrawIndexedIndirectCommand()
-                                             .setFirstInstance(0)
+                                             .setFirstInstance(static_cast<u32>(index))
                                              .setInstanceCount(1)
                                              .setFirstIndex(mesh.firstIndex)
                                              .setIndexCount(mesh.indexCount)
@@ -217,8 +257,12 @@ int main()
         .lutIndex = static_cast<int>(Swift::GetImageArrayIndex(lut)),
     };
 
-    const auto meshBuffer =
-        Swift::CreateBuffer(Swift::BufferType::eStorage, sizeof(Mesh) * totalMeshes, "Mesh Buffer");
+    // Read by the compute batch and the frame alike, so shared instead of handed back and forth
+    const auto meshBuffer = Swift::CreateBuffer(
+        Swift::BufferType::eStorage,
+        sizeof(Mesh) * totalMeshes,
+        "Mesh Buffer",
+        true);
     Swift::UploadToBuffer(meshBuffer, scene.meshes.data(), 0, sizeof(Mesh) * totalMeshes);
 
     IndirectFillPushConstant indirectFillPC = {
@@ -228,13 +272,28 @@ int main()
     };
 
     Swift::Frustum frustum;
-    const auto frustumBuffer =
-        Swift::CreateBuffer(Swift::BufferType::eUniform, sizeof(Swift::Frustum), "Frustum Buffer");
+    const auto frustumBuffer = Swift::CreateBuffer(
+        Swift::BufferType::eUniform,
+        sizeof(Swift::Frustum),
+        "Frustum Buffer",
+        true);
+    // Occlusion culling runs in the frame, so it gets a copy the compute queue never touches
+    const auto occlusionFrustumBuffer = Swift::CreateBuffer(
+        Swift::BufferType::eUniform,
+        sizeof(Swift::Frustum),
+        "Occlusion Frustum Buffer");
 
     const auto visibilityBuffer = Swift::CreateBuffer(
         Swift::BufferType::eStorage,
         sizeof(u32) * totalMeshes,
         "Visibility Buffer");
+    // Everything counts as visible until the GPU culling pass writes the buffer
+    const std::vector<u32> allVisible(totalMeshes, 1);
+    Swift::UploadToBuffer(visibilityBuffer, allVisible.data(), 0, sizeof(u32) * totalMeshes);
+
+    // Surviving draws are compacted to the front of the indirect buffer and counted here
+    const auto drawCountBuffer =
+        Swift::CreateBuffer(Swift::BufferType::eIndirect, sizeof(u32), "Draw Count Buffer");
 
     IndirectFillCullPushConstant indirectCullPC = {
         .indirectBuffer = Swift::GetBufferAddress(indirectBuffer),
@@ -243,6 +302,69 @@ int main()
         .boundingBuffer = Swift::GetBufferAddress(boundingBuffer),
         .transformBuffer = Swift::GetBufferAddress(transformBuffer),
         .visBuffer = Swift::GetBufferAddress(visibilityBuffer),
+        .countBuffer = Swift::GetBufferAddress(drawCountBuffer),
+        .meshCount = totalMeshes,
+    };
+
+    // Bounds stored per component for batched CPU culling, the CPU paths draw the draw list
+    Swift::BoundsSoA meshBounds;
+    meshBounds.Resize(totalMeshes);
+    for (u32 index = 0; index < totalMeshes; index++)
+    {
+        meshBounds.SetSphere(index, scene.boundingSpheres[index])
+            .SetTransform(index, scene.transforms[scene.meshes[index].transformIndex]);
+    }
+    const auto allMeshes = std::views::iota(0u, totalMeshes) | std::ranges::to<std::vector>();
+    std::vector<u32> visibleMeshes(totalMeshes);
+    constexpr u32 cullGrainSize = 4096;
+    // Hierarchy over the same bounds, the scene is static so it is built once and never refit
+    Swift::BVH meshBVH;
+    meshBVH.Build(meshBounds);
+    std::optional<Swift::RayHit> pickedMesh;
+
+    // Draws culled and built on the CPU, one buffer per frame slot so a frame never rewrites
+    // commands an earlier one may still be drawing with
+    std::vector<VkDrawIndexedIndirectCommand> cpuCommands(totalMeshes);
+    std::vector<Swift::BufferHandle> cpuIndirectBuffers(Swift::GetFramesInFlight());
+    for (auto& cpuIndirectBuffer : cpuIndirectBuffers)
+    {
+        cpuIndirectBuffer = Swift::CreateBuffer(
+            Swift::BufferType::eIndirect,
+            sizeof(vk::DrawIndexedIndirectCommand) * totalMeshes,
+            "Cpu Indirect Buffer");
+    }
+
+    // ------------------------------------Occlusion Culling---------------------------------------
+
+    Swift::Occlusion::Init(Swift::OcclusionInfo().SetReduceShader(depthReduceShader));
+    OcclusionCullPushConstant occlusionCullPC = {
+        .indirectBuffer = Swift::GetBufferAddress(indirectBuffer),
+        .meshBuffer = Swift::GetBufferAddress(meshBuffer),
+        .frustumBuffer = Swift::GetBufferAddress(occlusionFrustumBuffer),
+        .boundingBuffer = Swift::GetBufferAddress(boundingBuffer),
+        .transformBuffer = Swift::GetBufferAddress(transformBuffer),
+        .visBuffer = Swift::GetBufferAddress(visibilityBuffer),
+        .countBuffer = Swift::GetBufferAddress(drawCountBuffer),
+        .cameraBuffer = Swift::GetBufferAddress(cameraBuffer),
+        .meshCount = totalMeshes,
+    };
+
+    // --------------------------------------Texture Streaming-------------------------------------
+
+    Swift::Streaming::Init(Swift::StreamingInfo().SetLodCount(totalMeshes));
+    for (const auto& [index, image] : std::views::enumerate(images))
+    {
+        if (Swift::IsValid(image) && !textureMeshes[index].empty())
+        {
+            Swift::Streaming::RegisterImage(image, textureMeshes[index]);
+        }
+    }
+
+    StreamPushConstant streamPC = {
+        .transformBuffer = Swift::GetBufferAddress(transformBuffer),
+        .meshBuffer = Swift::GetBufferAddress(meshBuffer),
+        .lodBuffer = Swift::Streaming::GetLodBufferAddress(),
+        .visibilityBuffer = Swift::GetBufferAddress(visibilityBuffer),
         .meshCount = totalMeshes,
     };
 
@@ -258,16 +380,23 @@ int main()
     // -------------------------------------App Settings-------------------------------------------
     bool bGpuIndirect = false;
     bool bCpuFrustumCulling = false;
+    bool bCpuCullAndBuild = false;
+    bool bBvhCulling = false;
+    bool bParallelRecording = true;
     bool bGpuFrustumCulling = false;
+    bool bGpuOcclusionCulling = false;
+    bool bAsyncCompute = true;
     float minLodDistance = 5.f;
     float maxLodDistance = 100.f;
     bool bShowLod = false;
+    bool bTextureStreaming = true;
+    // Buffers the last frame released to compute, every one of them is handed back by the next
+    // compute batch even if async compute or the pass that needed them was turned off since
+    std::vector<Swift::BufferHandle> buffersOnCompute;
 
     // For tracking delta-time
     std::chrono::high_resolution_clock::time_point lastTime =
         std::chrono::high_resolution_clock::now();
-
-    std::future<std::unordered_map<Swift::ImageHandle, Swift::ImageHandle>> streamFuture;
     // -------------------------------------Game Loop----------------------------------------------
     while (Window::IsRunning())
     {
@@ -278,17 +407,55 @@ int main()
         lastTime = currentTime;
 
         const auto currentWindowSize = Window::GetSize();
+        const auto dynamicInfo = Swift::DynamicInfo().SetExtent(currentWindowSize);
+        // Nothing is drawn while the window is minimized, which also keeps its 0 size out of the
+        // camera and frustum math
+        if (!Swift::BeginFrame(dynamicInfo))
+        {
+            continue;
+        }
         const auto aspect =
             static_cast<float>(currentWindowSize.x) / static_cast<float>(currentWindowSize.y);
-        const auto dynamicInfo = Swift::DynamicInfo().SetExtent(currentWindowSize);
         Camera::HandleKeyboard(cameraData, deltaTime, moveSensitivity);
         Camera::HandleMouse(cameraData, deltaTime, lookSensitivity);
         Camera::Update(cameraData, fov, currentWindowSize, nearClip, farClip);
 
         Swift::ImGUI::BeginFrame();
-        Swift::BeginFrame(dynamicInfo);
+        // Picks the mesh under the cursor, unprojecting it to a ray through the near and far planes
+        if (Input::GetMouseButton(Input::MouseButton::Left) && !ImGui::GetIO().WantCaptureMouse)
+        {
+            const auto mousePosition = Input::GetMousePosition();
+            const auto ndc = mousePosition / glm::vec2(currentWindowSize) * 2.0f - 1.0f;
+            const auto inverseViewProjection = glm::inverse(cameraData.proj * cameraData.view);
+            const auto unproject = [&](const float depth)
+            {
+                const auto point = inverseViewProjection * glm::vec4(ndc, depth, 1.0f);
+                return glm::vec3(point) / point.w;
+            };
+            const auto nearPoint = unproject(-1.0f);
+            const auto farPoint = unproject(1.0f);
+            pickedMesh = meshBVH.Raycast(
+                nearPoint,
+                glm::normalize(farPoint - nearPoint),
+                glm::distance(nearPoint, farPoint));
+        }
+        if (bTextureStreaming)
+        {
+            Swift::Streaming::Update();
+        }
 
         Swift::UpdateSmallBuffer(cameraBuffer, 0, sizeof(CameraData), &cameraData);
+        // Culling, indirect fill and streaming LODs run on the compute queue, overlapping the
+        // previous frame. Occlusion culling needs this frame's depth, so it stays in the frame.
+        const auto bIndirectDraw = bGpuIndirect || bGpuFrustumCulling || bGpuOcclusionCulling;
+        const auto bComputeDraws = bIndirectDraw && !bGpuOcclusionCulling;
+        // A buffer released to compute needs a batch to hand it back, even if async compute was
+        // just turned off
+        const auto bComputeBatch = bAsyncCompute || !buffersOnCompute.empty();
+        if (bComputeBatch)
+        {
+            Swift::BeginCompute();
+        }
         Swift::Visibility::UpdateFrustum(
             frustum,
             cameraData.view,
@@ -299,76 +466,267 @@ int main()
             aspect);
         Swift::UpdateSmallBuffer(frustumBuffer, 0, sizeof(Swift::Frustum), &frustum);
 
-        if (bGpuFrustumCulling)
+        if (bComputeDraws && bGpuFrustumCulling)
         {
+            constexpr u32 zero = 0;
+            Swift::UpdateSmallBuffer(drawCountBuffer, 0, sizeof(u32), &zero);
+            Swift::BufferBarrier(drawCountBuffer);
             Swift::BindShader(indirectCullShader);
             Swift::PushConstant(indirectCullPC);
             Swift::DispatchCompute(totalMeshes / 256 + 1, 1, 1);
+            Swift::BufferBarrier(indirectBuffer);
+            Swift::BufferBarrier(drawCountBuffer);
         }
 
-        else if (bGpuIndirect)
+        else if (bComputeDraws)
         {
             Swift::BindShader(indirectFillShader);
             Swift::PushConstant(indirectFillPC);
             Swift::DispatchCompute(totalMeshes / 256 + 1, 1, 1);
+            Swift::BufferBarrier(indirectBuffer);
         }
 
-        Swift::ClearSwapchainImage(glm::vec4(1, 0, 0, 0));
-        Swift::BeginRendering();
+        if (bTextureStreaming)
+        {
+            streamPC.cameraPos = cameraData.pos;
+            streamPC.minDistance = minLodDistance;
+            streamPC.maxDistance = maxLodDistance;
+            Swift::BufferBarrier(visibilityBuffer);
+            Swift::BindShader(streamShader);
+            Swift::PushConstant(streamPC);
+            Swift::DispatchCompute(totalMeshes / 256 + 1, 1, 1);
+            Swift::Streaming::RecordReadback();
+        }
+        if (bComputeBatch)
+        {
+            // What the batch wrote goes to the frame, along with everything the last frame
+            // released whether the batch used it or not
+            if (bComputeDraws)
+            {
+                buffersOnCompute.emplace_back(indirectBuffer);
+            }
+            if (bComputeDraws && bGpuFrustumCulling)
+            {
+                buffersOnCompute.emplace_back(drawCountBuffer);
+            }
+            std::ranges::sort(buffersOnCompute);
+            const auto [first, last] = std::ranges::unique(buffersOnCompute);
+            buffersOnCompute.erase(first, last);
+            for (const auto buffer : buffersOnCompute)
+            {
+                Swift::ReleaseToGraphics(buffer);
+            }
+            buffersOnCompute.clear();
+            Swift::EndCompute();
+        }
 
-        Swift::BindIndexBuffer(indexBuffer);
+        // CPU culling runs on the job system, each range writing its survivors straight into place
+        const auto bCpuIndirect = bCpuCullAndBuild && !bIndirectDraw;
+        const auto cpuIndirectBuffer = cpuIndirectBuffers[Swift::GetFrameIndex()];
+        u32 cpuDrawCount = 0;
+        if (bCpuIndirect)
+        {
+            cpuDrawCount = Swift::Visibility::CullAndBuild(
+                Swift::GetJobSystem(),
+                frustum,
+                meshBounds,
+                cullGrainSize,
+                [&](const u32 firstSlot, const std::span<const u32> indices)
+                {
+                    for (const auto [offset, index] : std::views::enumerate(indices))
+                    {
+                        cpuCommands[firstSlot + offset] = indirectCommands[index];
+                    }
+                });
+            if (cpuDrawCount > 0)
+            {
+                Swift::UploadToBuffer(
+                    cpuIndirectBuffer,
+                    cpuCommands.data(),
+                    0,
+                    sizeof(vk::DrawIndexedIndirectCommand) * cpuDrawCount);
+            }
+        }
 
-        if (bGpuIndirect || bGpuFrustumCulling)
+        std::span<const u32> drawList = allMeshes;
+        if (bCpuFrustumCulling && !bIndirectDraw && !bCpuIndirect && bBvhCulling)
         {
-            Swift::BindShader(indirectDrawShader);
-            Swift::PushConstant(indirectPC);
-            Swift::DrawIndexedIndirect(
-                indirectBuffer,
-                0,
-                totalMeshes,
-                sizeof(vk::DrawIndexedIndirectCommand));
+            const auto visibleCount = meshBVH.QueryFrustum(frustum, visibleMeshes);
+            drawList = std::span(visibleMeshes).first(visibleCount);
         }
+        else if (bCpuFrustumCulling && !bIndirectDraw && !bCpuIndirect)
+        {
+            const auto visibleCount = Swift::Visibility::CullAndBuild(
+                Swift::GetJobSystem(),
+                frustum,
+                meshBounds,
+                cullGrainSize,
+                [&](const u32 firstSlot, const std::span<const u32> indices)
+                {
+                    std::ranges::copy(indices, visibleMeshes.begin() + firstSlot);
+                });
+            drawList = std::span(visibleMeshes).first(visibleCount);
+        }
+        const auto drawCount = static_cast<u32>(drawList.size());
 
-        else
+        const auto drawMeshes = [&](const u32 first, const u32 last)
         {
+            Swift::BindIndexBuffer(indexBuffer);
             Swift::BindShader(graphicsShader);
-            for (const auto& [index, mesh] : std::views::enumerate(scene.meshes))
+            auto pushConstant = scene.pushConstant;
+            for (const auto index : drawList.subspan(first, last - first))
             {
-                auto& pushConstant = scene.pushConstant;
+                const auto& mesh = scene.meshes[index];
                 pushConstant.transformIndex = mesh.transformIndex;
                 pushConstant.materialIndex = mesh.materialIndex;
-
-                if (bCpuFrustumCulling)
-                {
-                    const auto visible = Swift::Visibility::IsInFrustum(
-                        frustum,
-                        scene.boundingSpheres[index],
-                        scene.transforms[mesh.transformIndex]);
-                    if (!visible)
-                        continue;
-                }
-                Swift::PushConstant(scene.pushConstant);
+                Swift::PushConstant(pushConstant);
                 Swift::DrawIndexed(mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, 0);
             }
-        }
+        };
 
-        SkyboxPushConstant skyboxPushConstant{
-            .vertexBuffer = Swift::GetBufferAddress(cubeVertexBuffer),
-            .cameraBuffer = Swift::GetBufferAddress(cameraBuffer),
-            .cubemapIndex = Swift::GetImageArrayIndex(skybox),
+        const auto drawSkybox = [&]
+        {
+            SkyboxPushConstant skyboxPushConstant{
+                .vertexBuffer = Swift::GetBufferAddress(cubeVertexBuffer),
+                .cameraBuffer = Swift::GetBufferAddress(cameraBuffer),
+                .cubemapIndex = Swift::GetImageArrayIndex(skybox),
+            };
+
+            Swift::BindShader(skyboxShader);
+            Swift::BindIndexBuffer(cubeIndexBuffer);
+            Swift::SetPolygonMode(Swift::PolygonMode::eFill);
+            Swift::SetCullMode(Swift::CullMode::eFront);
+            Swift::SetDepthCompareOp(Swift::DepthCompareOp::eLessOrEqual);
+            Swift::PushConstant(skyboxPushConstant);
+
+            const auto cube = cubeScene.meshes[cubeIndex.value()[0]];
+            Swift::DrawIndexed(cube.indexCount, 1, cube.firstIndex, cube.vertexOffset, 0);
         };
 
-        Swift::BindShader(skyboxShader);
-        Swift::BindIndexBuffer(cubeIndexBuffer);
-        Swift::SetPolygonMode(Swift::PolygonMode::eFill);
-        Swift::SetCullMode(Swift::CullMode::eFront);
-        Swift::SetDepthCompareOp(Swift::DepthCompareOp::eLessOrEqual);
-        Swift::PushConstant(skyboxPushConstant);
+        const auto occlusionCull = [&](const u32 latePass)
+        {
+            constexpr u32 zero = 0;
+            Swift::UpdateSmallBuffer(drawCountBuffer, 0, sizeof(u32), &zero);
+            Swift::BufferBarrier(drawCountBuffer);
+            Swift::BindShader(occlusionCullShader);
+            occlusionCullPC.latePass = latePass;
+            Swift::PushConstant(occlusionCullPC);
+            Swift::DispatchCompute(totalMeshes / 256 + 1, 1, 1);
+            Swift::BufferBarrier(indirectBuffer);
+            Swift::BufferBarrier(drawCountBuffer);
+        };
 
-        const auto cube = cubeScene.meshes[cubeIndex.value()[0]];
-        Swift::DrawIndexed(cube.indexCount, 1, cube.firstIndex, cube.vertexOffset, 0);
+        const auto drawCulled = [&]
+        {
+            Swift::BindIndexBuffer(indexBuffer);
+            Swift::BindShader(indirectDrawShader);
+            Swift::PushConstant(indirectPC);
+            Swift::DrawIndexedIndirectCount(
+                indirectBuffer,
+                0,
+                drawCountBuffer,
+                0,
+                totalMeshes,
+                sizeof(vk::DrawIndexedIndirectCommand));
+        };
+
+        Swift::ClearSwapchainImage(glm::vec4(1, 0, 0, 0));
+        if (bGpuOcclusionCulling)
+        {
+            Swift::UpdateSmallBuffer(occlusionFrustumBuffer, 0, sizeof(Swift::Frustum), &frustum);
+            Swift::BufferBarrier(occlusionFrustumBuffer);
+            // Whatever was visible last frame is drawn first and becomes the occluders the late
+            // pass tests everything against, drawing only what the early pass missed
+            occlusionCull(0);
+            Swift::BeginRendering();
+            drawCulled();
+            Swift::EndRendering();
+
+            Swift::Occlusion::BuildDepthPyramid();
+            occlusionCullPC.depthPyramid = Swift::Occlusion::GetDepthPyramidAddress();
+            occlusionCull(1);
+            Swift::ResumeRendering();
+            drawCulled();
+            drawSkybox();
+        }
+        else if (bIndirectDraw)
+        {
+            Swift::BeginRendering();
+            if (bGpuFrustumCulling)
+            {
+                drawCulled();
+            }
+            else
+            {
+                Swift::BindIndexBuffer(indexBuffer);
+                Swift::BindShader(indirectDrawShader);
+                Swift::PushConstant(indirectPC);
+                Swift::DrawIndexedIndirect(
+                    indirectBuffer,
+                    0,
+                    totalMeshes,
+                    sizeof(vk::DrawIndexedIndirectCommand));
+            }
+            drawSkybox();
+        }
+        else if (bCpuIndirect)
+        {
+            Swift::BeginRendering();
+            Swift::BindIndexBuffer(indexBuffer);
+            Swift::BindShader(indirectDrawShader);
+            Swift::PushConstant(indirectPC);
+            Swift::DrawIndexedIndirect(
+                cpuIndirectBuffer,
+                0,
+                cpuDrawCount,
+                sizeof(vk::DrawIndexedIndirectCommand));
+            drawSkybox();
+        }
+        else if (bParallelRecording)
+        {
+            // Each job records its own slice of the meshes on a worker thread
+            constexpr u32 meshesPerJob = 512;
+            Swift::BeginParallelRendering();
+            Swift::RecordParallel(
+                (drawCount + meshesPerJob - 1) / meshesPerJob,
+                [&](const u32 job)
+                {
+                    const auto first = job * meshesPerJob;
+                    drawMeshes(first, std::min(first + meshesPerJob, drawCount));
+                });
+            Swift::RecordParallel(
+                1,
+                [&](u32)
+                {
+                    drawSkybox();
+                });
+        }
+        else
+        {
+            Swift::BeginRendering();
+            drawMeshes(0, drawCount);
+            drawSkybox();
+        }
 
         Swift::EndRendering();
+        if (bAsyncCompute && bComputeDraws)
+        {
+            // The next compute batch overwrites the commands this frame draws with
+            buffersOnCompute.emplace_back(indirectBuffer);
+            if (bGpuFrustumCulling)
+            {
+                buffersOnCompute.emplace_back(drawCountBuffer);
+            }
+        }
+        if (bAsyncCompute && bGpuOcclusionCulling)
+        {
+            // Streaming reads the visibility the late pass wrote
+            buffersOnCompute.emplace_back(visibilityBuffer);
+        }
+        for (const auto buffer : buffersOnCompute)
+        {
+            Swift::ReleaseToCompute(buffer);
+        }
 
         Swift::ImGUI::ShowDebugStats();
 
@@ -385,16 +743,35 @@ int main()
         ImGui::Text("Draw Settings");
         ImGui::Checkbox("Gpu Indirect Drawing", &bGpuIndirect);
         ImGui::Checkbox("Cpu Culling", &bCpuFrustumCulling);
+        ImGui::Checkbox("Cpu Cull And Build", &bCpuCullAndBuild);
+        ImGui::Checkbox("Bvh Culling", &bBvhCulling);
+        ImGui::Checkbox("Parallel Recording", &bParallelRecording);
         ImGui::Checkbox("Gpu Culling", &bGpuFrustumCulling);
+        ImGui::Checkbox("Gpu Occlusion Culling", &bGpuOcclusionCulling);
+        ImGui::Checkbox("Async Compute", &bAsyncCompute);
         ImGui::SliderFloat("Min LOD Distance", &minLodDistance, 0.01f, 100.0f);
         ImGui::SliderFloat("Max LOD Distance", &maxLodDistance, 0.01f, 1000.0f);
         ImGui::Checkbox("Show LOD", &bShowLod);
+        ImGui::Checkbox("Texture Streaming", &bTextureStreaming);
 
         ImGui::Text("Statistics");
         ImGui::Text("Total Vertices: %d", totalVertices);
         ImGui::Text("Total Triangles: %d", totalTriangles);
         ImGui::Text("Total Meshes: %d", totalMeshes);
         ImGui::Text("FPS: %f", 1.f / deltaTime);
+        ImGui::Text(
+            "Streamed Texture Memory: %.1f MB",
+            static_cast<float>(Swift::Streaming::GetResidentMemory()) / (1024.f * 1024.f));
+        ImGui::Text("Pending Texture Loads: %u", Swift::Streaming::GetPendingLoadCount());
+        ImGui::Text("Bvh Nodes: %u", meshBVH.GetNodeCount());
+        if (pickedMesh)
+        {
+            ImGui::Text("Picked Mesh: %u (%.2f away)", pickedMesh->index, pickedMesh->distance);
+        }
+        else
+        {
+            ImGui::Text("Picked Mesh: None");
+        }
 
         ImGui::End();
         Swift::ImGUI::RenderImGUI();
@@ -402,6 +779,8 @@ int main()
         Swift::ImGUI::EndFrame();
     }
 
+    Swift::Occlusion::Shutdown();
+    Swift::Streaming::Shutdown();
     Swift::ImGUI::Shutdown();
     Swift::Shutdown();
     Window::Shutdown();
@@ -53,9 +53,25 @@ struct IndirectFillCullPushConstant
     u64 boundingBuffer = 0;
     u64 transformBuffer = 0;
     u64 visBuffer = 0;
+    u64 countBuffer = 0;
     u32 meshCount = 0;
 };
 
+struct OcclusionCullPushConstant
+{
+    u64 indirectBuffer = 0;
+    u64 meshBuffer = 0;
+    u64 frustumBuffer = 0;
+    u64 boundingBuffer = 0;
+    u64 transformBuffer = 0;
+    u64 visBuffer = 0;
+    u64 countBuffer = 0;
+    u64 cameraBuffer = 0;
+    u64 depthPyramid = 0;
+    u32 meshCount = 0;
+    u32 latePass = 0;
+};
+
 struct StreamPushConstant
 {
     u64 transformBuffer{};
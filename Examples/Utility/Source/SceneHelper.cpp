@@ -6,13 +6,14 @@ namespace
 {
     void LoadTextures(Scene& scene)
     {
-        Swift::BeginTransfer();
+        const auto images = Swift::LoadImagesFromFiles(scene.uris, 0, true);
 
         std::unordered_map<u32, int> textureIndices;
-        for (const auto& [index, uri] : std::views::enumerate(scene.uris))
+        for (const auto& [index, image] : std::views::enumerate(images))
         {
-            const auto image = Swift::LoadImageFromFileQueued(uri, 0, true, uri);
-            textureIndices[index] = static_cast<int>(Swift::GetImageArrayIndex(image));
+            // Textures that failed to load are sampled as if the material had none
+            textureIndices[index] =
+                Swift::IsValid(image) ? static_cast<int>(Swift::GetImageArrayIndex(image)) : -1;
         }
 
         // Update the material texture indices so that we can index into the texture in the shader
@@ -40,8 +41,6 @@ namespace
                 material.occlusionTextureIndex = textureIndices.at(material.occlusionTextureIndex);
             }
         }
-
-        Swift::EndTransfer();
     }
 } // namespace
 
@@ -5,6 +5,8 @@
 
 namespace Swift
 {
+    class JobSystem;
+
     void Init(const InitInfo& initInfo);
     void Shutdown();
 
@@ -18,17 +20,50 @@ namespace Swift
     void WaitIdle();
 
     bool SupportsGraphicsMultithreading();
+    // Whether compute shaders may use GL_KHR_shader_subgroup_ballot
+    bool SupportsSubgroupBallot();
+
+    // Index of the frame slot being recorded, cycles through [0, GetFramesInFlight())
+    u32 GetFrameIndex();
+    u32 GetFramesInFlight();
+    // Frames the GPU may fall behind the CPU before BeginFrame blocks, clamped to
+    // [1, GetFramesInFlight()]. 0 resets it to GetFramesInFlight().
+    void SetMaxFrameLatency(u32 maxFrameLatency);
+    u32 GetMaxFrameLatency();
+    // Work stealing job system for CPU work within a frame, such as culling. Created on first use.
+    JobSystem& GetJobSystem();
+    // Follows the window once BeginFrame has recreated the swapchain
+    glm::uvec2 GetSwapchainExtent();
+    // Headless runs have one offscreen image per frame in flight
+    u32 GetSwapchainImageCount();
 
     inline bool IsValid(const Swift::BufferHandle handle)
     {
         return handle != InvalidHandle;
     }
 
-    void BeginFrame(const DynamicInfo& dynamicInfo);
+    // False when there is nothing to present to, such as a minimized window. Skip the frame's
+    // recording and EndFrame then.
+    [[nodiscard]]
+    bool BeginFrame(const DynamicInfo& dynamicInfo);
     void EndFrame(const DynamicInfo& dynamicInfo);
 
     void BeginRendering();
     void EndRendering();
+    // Begins rendering to the swapchain like BeginRendering, but keeps the depth an earlier
+    // rendering in the frame wrote instead of clearing it
+    void ResumeRendering();
+
+    // Begins rendering to the swapchain like BeginRendering, but its contents can only be recorded
+    // with RecordParallel. End it with EndRendering.
+    void BeginParallelRendering();
+    // Runs record once per job on the thread pool and the calling thread. The bind, state, push
+    // constant and draw calls it makes go into that job's own secondary command buffer, and the
+    // jobs are executed in index order. Each job starts from the default pipeline state with
+    // nothing bound. Shaders that are still compiling bind like they do outside of it.
+    void RecordParallel(
+        u32 jobCount,
+        const std::function<void(u32 jobIndex)>& record);
 
     void BeginRendering(ImageHandle image);
     void EndRendering(ImageHandle image);
@@ -36,6 +71,9 @@ namespace Swift
     void SetCullMode(const CullMode& cullMode);
     void SetDepthCompareOp(DepthCompareOp depthCompareOp);
     void SetPolygonMode(PolygonMode polygonMode);
+    // Redundant binds and state changes are skipped, so call this after recording commands into
+    // the frame's command buffer outside of Swift
+    void InvalidateState();
 
     void Draw(
         u32 vertexCount,
@@ -70,6 +108,23 @@ namespace Swift
         const std::string& computePath,
         std::string_view debugName);
 
+    // Compile on the thread pool and return a handle right away. Until the shader is ready,
+    // BindShader binds the fallback shader of the same kind, or waits if none was set or the
+    // fallback's push constant block differs from the pending shader's.
+    ShaderHandle CreateGraphicsShaderAsync(
+        std::string_view vertexPath,
+        std::string_view fragmentPath,
+        std::string_view debugName);
+    ShaderHandle CreateComputeShaderAsync(
+        const std::string& computePath,
+        std::string_view debugName);
+    bool IsShaderReady(ShaderHandle shaderHandle);
+    // Waits for the shader if it is still compiling. The fallback runs with the push constants
+    // and draw or dispatch sizes meant for the shader it stands in for, so it has to share their
+    // interface and be safe to run on that data.
+    void SetFallbackShader(ShaderHandle shaderHandle);
+    void DestroyShader(ShaderHandle shaderHandle);
+
     void BindShader(const ShaderHandle& shaderHandle);
 
     void PushConstant(
@@ -92,6 +147,8 @@ namespace Swift
         glm::uvec2 size,
         std::string_view debugName);
     void DestroyImage(ImageHandle imageHandle);
+    // The loads return InvalidHandle when the file is missing or is not a DDS file Vulkan can
+    // sample, LoadImagesFromFiles does so per file
     ImageHandle LoadImageFromFile(
         const std::filesystem::path& filePath,
         int mipLevel,
@@ -106,6 +163,29 @@ namespace Swift
         std::string_view debugName,
         bool tempImage = false,
         ThreadHandle thread = -1);
+    // Decodes and uploads the files on a worker pool and submits them as one transfer batch.
+    // Must not be called between BeginTransfer and EndTransfer.
+    std::vector<ImageHandle> LoadImagesFromFiles(
+        std::span<const std::string> filePaths,
+        int mipLevel,
+        bool loadAllMipMaps);
+    // Allocates the full mip chain up front but only uploads residentMip and coarser. Finer mips
+    // are added in place with LoadImageMipQueued and made visible with SetImageMinLod.
+    ImageHandle LoadImageFromFileProgressive(
+        const std::filesystem::path& filePath,
+        int residentMip,
+        std::string_view debugName);
+    // Must be called between BeginTransfer and EndTransfer. False when the file can no longer be
+    // read, nothing is recorded then.
+    bool LoadImageMipQueued(
+        ImageHandle image,
+        int mipLevel);
+    // Clamps sampling to minLod and finer with VK_EXT_image_view_min_lod, from the next BeginFrame
+    // on. Only valid for images from LoadImageFromFileProgressive once the mips down to minLod
+    // have finished uploading.
+    void SetImageMinLod(
+        ImageHandle image,
+        int minLod);
     ImageHandle LoadCubemapFromFile(
         const std::filesystem::path& filePath,
         std::string_view debugName);
@@ -114,16 +194,24 @@ namespace Swift
     int GetMaxLod(ImageHandle image);
     u32 GetImageArrayIndex(ImageHandle imageHandle);
     std::string_view GetURI(ImageHandle imageHandle);
+    glm::uvec2 GetImageSize(ImageHandle imageHandle);
+    // Size of the image's device memory allocation in bytes
+    u64 GetImageMemorySize(ImageHandle imageHandle);
+    // InvalidHandle when no live image sits at imageIndex
     ImageHandle ReadOnlyImageFromIndex(int imageIndex);
     void UpdateImage(
         ImageHandle baseImage,
         ImageHandle tempImage);
     void ClearTempImages();
 
+    // Compute shared buffers can be used by compute batches without ReleaseToCompute, and must
+    // never be passed to it. Meant for data the compute queue reads alongside the frame, as
+    // concurrent sharing may cost some GPU performance.
     BufferHandle CreateBuffer(
         BufferType bufferType,
         u32 size,
-        std::string_view debugName);
+        std::string_view debugName,
+        bool bComputeShared = false);
     void DestroyBuffer(BufferHandle bufferHandle);
 
     void* MapBuffer(BufferHandle bufferHandle);
@@ -156,6 +244,8 @@ namespace Swift
         u64 size);
 
     u64 GetBufferAddress(const BufferHandle& buffer);
+    // Makes earlier writes to the buffer visible to every later command in the frame
+    void BufferBarrier(BufferHandle bufferHandle);
     void BindIndexBuffer(const BufferHandle& bufferObject);
 
     void ClearImage(
@@ -177,9 +267,34 @@ namespace Swift
     void BlitToSwapchain(
         ImageHandle srcImageHandle,
         glm::uvec2 srcExtent);
+    // Read back the current swapchain image, e.g. for headless rendering
+    void CopySwapchainToBuffer(BufferHandle dstBufferHandle);
+    // Copies the swapchain depth as one float per texel, row after row. Record outside rendering.
+    void CopyDepthToBuffer(BufferHandle dstBufferHandle);
 
     void BeginTransfer(ThreadHandle threadHandle = -1);
-    void EndTransfer(ThreadHandle threadHandle = -1);
+    // Submits the recorded uploads without waiting for them. Frames submitted afterwards wait
+    // for the uploads on the GPU. Thread transfers block and return an already completed ticket.
+    TransferTicket EndTransfer(ThreadHandle threadHandle = -1);
+    bool IsTransferComplete(TransferTicket ticket);
+    void WaitTransfer(TransferTicket ticket);
+
+    // Shader binds, push constants, dispatches, buffer updates, copies and barriers recorded until
+    // EndCompute go to the dedicated compute queue instead of the frame. The batch waits for
+    // earlier uploads and for the frames that released its buffers with ReleaseToCompute.
+    void BeginCompute();
+    // Submits the batch without waiting for it. Frames submitted afterwards wait for it on the GPU.
+    ComputeTicket EndCompute();
+    bool IsComputeComplete(ComputeTicket ticket);
+    void WaitCompute(ComputeTicket ticket);
+    // Buffers that are not compute shared belong to the graphics queue family. A buffer whose
+    // contents a compute batch reads, or that the frame still uses before the batch overwrites it,
+    // has to be released by the frame first. Compute batches begun after that frame is submitted
+    // acquire it, and the next one has to hand it back even if it no longer uses the buffer.
+    void ReleaseToCompute(BufferHandle bufferHandle);
+    // Hands a buffer written by the compute batch back to the graphics queue. The acquire is
+    // recorded into the frame being recorded, or the next one.
+    void ReleaseToGraphics(BufferHandle bufferHandle);
 
     ThreadHandle CreateGraphicsThreadContext();
     void DestroyGraphicsThreadContext(ThreadHandle threadHandle);
@@ -0,0 +1,66 @@
+#pragma once
+#include "SwiftStructs.hpp"
+
+namespace Swift
+{
+    struct RayHit
+    {
+        u32 index = InvalidHandle;
+        float distance{};
+    };
+
+    // Bounding volume hierarchy over the world space spheres of a BoundsSoA, built with a binned
+    // surface area heuristic. Objects of a subtree are stored next to each other, so subtrees that
+    // are fully inside a frustum are emitted without visiting their nodes.
+    class BVH
+    {
+    public:
+        void Build(const BoundsSoA& bounds);
+        // Moves the changed objects' boxes and the boxes above them, keeping the tree as built.
+        // Rebuild instead once objects have moved far from where they were.
+        void Refit(
+            const BoundsSoA& bounds,
+            std::span<const u32> changedIndices);
+        void Refit(const BoundsSoA& bounds);
+
+        // Writes the indices of the objects inside the frustum to the front of visibleIndices,
+        // which needs room for every object, and returns how many were written. The order follows
+        // the tree, not the indices.
+        u32 QueryFrustum(
+            const Frustum& frustum,
+            std::span<u32> visibleIndices) const;
+        // Closest object whose bounding sphere the ray hits within maxDistance. The direction
+        // has to be normalized.
+        std::optional<RayHit> Raycast(
+            glm::vec3 origin,
+            glm::vec3 direction,
+            float maxDistance = std::numeric_limits<float>::max()) const;
+
+        u32 GetNodeCount() const { return static_cast<u32>(nodes.size()); }
+
+    private:
+        struct Node
+        {
+            glm::vec3 min{};
+            // Range in objectIndices covered by the subtree
+            u32 first{};
+            glm::vec3 max{};
+            u32 count{};
+            // Children are stored next to each other, 0 marks a leaf since the root is nobody's
+            u32 left{};
+            u32 parent{};
+        };
+
+        void UpdateSphere(
+            const BoundsSoA& bounds,
+            u32 index);
+        void FitNode(Node& node) const;
+        void Split(u32 nodeIndex);
+
+        std::vector<Node> nodes;
+        std::vector<u32> objectIndices;
+        // World space center and radius per object
+        std::vector<glm::vec4> spheres;
+        std::vector<u32> objectLeaves;
+    };
+} // namespace Swift
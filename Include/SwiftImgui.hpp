@@ -21,14 +21,19 @@ namespace Swift::ImGUI
         io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
         io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
         auto format = VK_FORMAT_B8G8R8A8_UNORM;
+        // Taken from the renderer rather than the surface, which headless runs don't have. ImGui
+        // buffers its vertices per image, so there have to be at least as many as frames in
+        // flight, and it never accepts fewer than two.
+        const auto minImageCount = std::max(Swift::GetFramesInFlight(), 2u);
+        const auto imageCount = std::max(Swift::GetSwapchainImageCount(), minImageCount);
         ImGui_ImplVulkan_InitInfo vulkanInitInfo{
             .Instance = context.instance,
             .PhysicalDevice = context.gpu,
             .Device = context.device,
             .QueueFamily = index,
             .Queue = queue,
-            .MinImageCount = Vulkan::Util::GetSwapchainImageCount(context.gpu, context.surface),
-            .ImageCount = Vulkan::Util::GetSwapchainImageCount(context.gpu, context.surface),
+            .MinImageCount = minImageCount,
+            .ImageCount = imageCount,
             .MSAASamples = VK_SAMPLE_COUNT_1_BIT,
             .DescriptorPoolSize = 1000,
             .UseDynamicRendering = true,
@@ -61,6 +66,8 @@ namespace Swift::ImGUI
         ImGui_ImplVulkan_RenderDrawData(
             ImGui::GetDrawData(),
             Swift::GetGraphicsCommand().commandBuffer);
+        // ImGui binds its own pipeline and state
+        Swift::InvalidateState();
         Swift::EndRendering();
     }
 
@@ -0,0 +1,38 @@
+#pragma once
+#include "SwiftStructs.hpp"
+
+namespace Swift
+{
+    struct OcclusionInfo
+    {
+        // Compute shader with an 8x8 workgroup that reduces one pyramid level into the next. Its
+        // push constants are the source and destination buffer addresses followed by their sizes
+        // as uvec2, and every destination texel keeps the farthest depth of the source texels it
+        // covers. Mandatory
+        ShaderHandle reduceShader = InvalidHandle;
+
+        OcclusionInfo& SetReduceShader(const ShaderHandle reduceShader)
+        {
+            this->reduceShader = reduceShader;
+            return *this;
+        }
+    };
+
+    // Hierarchical depth for GPU occlusion culling. The swapchain depth is reduced into a pyramid
+    // kept in a storage buffer, laid out as the mip count padded to 16 bytes, then width, height
+    // and texel offset of each mip as uvec4, then the float texels. Mip 0 is the depth reduced to
+    // the largest power of two size that fits in it.
+    namespace Occlusion
+    {
+        constexpr u32 MaxPyramidMips = 16;
+
+        void Init(const OcclusionInfo& occlusionInfo);
+        void Shutdown();
+
+        // Record into the frame, outside rendering, once the occluders have been drawn. The pyramid
+        // follows swapchain resizes, so fetch its address again afterwards.
+        void BuildDepthPyramid();
+        u64 GetDepthPyramidAddress();
+        glm::uvec2 GetDepthPyramidSize();
+    } // namespace Occlusion
+} // namespace Swift
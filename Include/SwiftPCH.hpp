@@ -12,6 +12,15 @@
 #include "iostream"
 #include "variant"
 #include "format"
+#include "functional"
+#include "deque"
+#include "optional"
+#include "mutex"
+#include "thread"
+#include "future"
+#include "condition_variable"
+#include "atomic"
+#include "span"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/glm.hpp"
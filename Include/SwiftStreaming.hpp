@@ -0,0 +1,74 @@
+#pragma once
+#include "SwiftStructs.hpp"
+
+namespace Swift
+{
+    struct StreamingInfo
+    {
+        // Number of LOD entries the streaming compute shader writes, one float per entry. Mandatory
+        u32 lodCount{};
+        // Device memory the streamed images may occupy in total. Optional
+        u64 memoryBudget = 512 * 1024 * 1024;
+        // Upper bound on mip swaps started per frame, keeps the transfer cost per frame bounded.
+        // Optional
+        u32 maxLoadsPerFrame = 4;
+        // Added to the requested LOD before it is turned into a mip level. Optional
+        int mipBias{};
+        // Refine images from LoadImageFromFileProgressive in place, one mip at a time from
+        // coarse to fine, instead of reloading them into a new image. Their full chain is
+        // allocated up front, so mips are never dropped and the budget does not apply. Optional
+        bool bInPlaceMips{};
+
+        StreamingInfo& SetLodCount(const u32 lodCount)
+        {
+            this->lodCount = lodCount;
+            return *this;
+        }
+        StreamingInfo& SetMemoryBudget(const u64 memoryBudget)
+        {
+            this->memoryBudget = memoryBudget;
+            return *this;
+        }
+        StreamingInfo& SetMaxLoadsPerFrame(const u32 maxLoadsPerFrame)
+        {
+            this->maxLoadsPerFrame = maxLoadsPerFrame;
+            return *this;
+        }
+        StreamingInfo& SetMipBias(const int mipBias)
+        {
+            this->mipBias = mipBias;
+            return *this;
+        }
+        StreamingInfo& SetInPlaceMips(const bool inPlaceMips)
+        {
+            this->bInPlaceMips = inPlaceMips;
+            return *this;
+        }
+    };
+
+    // Streams DDS mip levels in and out based on the per entry LOD a compute shader writes into
+    // the LOD buffer. The LODs are read back a full frame cycle later, so nothing waits on the GPU.
+    namespace Streaming
+    {
+        void Init(const StreamingInfo& streamingInfo);
+        void Shutdown();
+
+        // The image is streamed at the finest mip any of the LOD entries asks for
+        void RegisterImage(
+            ImageHandle image,
+            std::span<const u32> lodIndices);
+        void UnregisterImage(ImageHandle image);
+
+        // Address of the float buffer the streaming compute shader writes its LODs into
+        u64 GetLodBufferAddress();
+
+        // Record after the streaming compute shader has been dispatched in the current frame
+        void RecordReadback();
+        // Call once per frame after BeginFrame. Swaps in finished loads, then queues new ones from
+        // the LODs this frame slot read back last time it was used.
+        void Update();
+
+        u64 GetResidentMemory();
+        u32 GetPendingLoadCount();
+    } // namespace Streaming
+} // namespace Swift
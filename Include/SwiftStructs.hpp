@@ -11,13 +11,33 @@ namespace Swift
         std::string engineName{};
         // Extent of the swapchain to be created. Mandatory
         glm::uvec2 extent{};
-        // Native window handle. Mandatory
+        // Native window handle. Mandatory unless headless
         // TODO: add sdl support
         std::variant<GLFWwindow*> windowHandle{};
 
+        // Render into a ring of offscreen images instead of a window surface. No window or
+        // display server is needed, so this also works on software drivers like lavapipe. Optional
+        bool bHeadless{};
+
         // Use for wider support of GPUs and possibly better performance. Optional
         bool bUsePipelines{};
 
+        // Frames the CPU may record while the GPU still works on earlier ones. Each one owns its
+        // command buffers and per frame resources, independent of the swapchain image count.
+        // Lower values cut input latency, higher ones keep the GPU fed. Optional
+        u32 framesInFlight = 2;
+        // Frames BeginFrame lets the GPU fall behind before it blocks, clamped to framesInFlight.
+        // 0 uses framesInFlight. Can be changed at runtime with SetMaxFrameLatency. Optional
+        u32 maxFrameLatency{};
+
+        // Size of the persistently mapped staging ring used for uploads. Optional
+        u64 stagingBufferSize = 64 * 1024 * 1024;
+
+        // File the pipeline cache is loaded from at init and written back to at shutdown. A cache
+        // from another driver or GPU is discarded. Leave empty to keep the cache in memory only.
+        // Optional
+        std::string pipelineCachePath{};
+
         // Use to prefer integrated graphics over dedicated ones (Dedicated graphics are
         // preferred by default)
         bool bPreferIntegratedGraphics{};
@@ -42,6 +62,31 @@ namespace Swift
             this->windowHandle = window;
             return *this;
         }
+        InitInfo& SetHeadless(const bool headless)
+        {
+            this->bHeadless = headless;
+            return *this;
+        }
+        InitInfo& SetFramesInFlight(const u32 framesInFlight)
+        {
+            this->framesInFlight = framesInFlight;
+            return *this;
+        }
+        InitInfo& SetMaxFrameLatency(const u32 maxFrameLatency)
+        {
+            this->maxFrameLatency = maxFrameLatency;
+            return *this;
+        }
+        InitInfo& SetStagingBufferSize(const u64 size)
+        {
+            this->stagingBufferSize = size;
+            return *this;
+        }
+        InitInfo& SetPipelineCachePath(const std::string_view pipelineCachePath)
+        {
+            this->pipelineCachePath = pipelineCachePath;
+            return *this;
+        }
         InitInfo& SetUsePipelines(const bool usePipelines)
         {
             this->bUsePipelines = usePipelines;
@@ -70,6 +115,8 @@ namespace Swift
     using BufferHandle = u32;
     using ImageHandle = u32;
     using ThreadHandle = u32;
+    using TransferTicket = u64;
+    using ComputeTicket = u64;
 
     struct BoundingSphere
     {
@@ -113,4 +160,55 @@ namespace Swift
         Plane nearFace;
         Plane farFace;
     };
+
+    // Object space bounding spheres with the transforms placing them, one array per component so
+    // batched culling loads several objects per instruction
+    struct BoundsSoA
+    {
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> radius;
+        // Upper three rows of each transform, indexed by column * 3 + row
+        std::array<std::vector<float>, 12> transform;
+
+        void Resize(const u32 count)
+        {
+            centerX.resize(count);
+            centerY.resize(count);
+            centerZ.resize(count);
+            radius.resize(count);
+            for (auto& component : transform)
+            {
+                component.resize(count);
+            }
+        }
+        u32 GetCount() const
+        {
+            return static_cast<u32>(centerX.size());
+        }
+        BoundsSoA& SetSphere(
+            const u32 index,
+            const BoundingSphere& sphere)
+        {
+            centerX[index] = sphere.center.x;
+            centerY[index] = sphere.center.y;
+            centerZ[index] = sphere.center.z;
+            radius[index] = sphere.radius;
+            return *this;
+        }
+        BoundsSoA& SetTransform(
+            const u32 index,
+            const glm::mat4& worldTransform)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    transform[column * 3 + row][index] = worldTransform[column][row];
+                }
+            }
+            return *this;
+        }
+    };
 }  // namespace Swift
\ No newline at end of file
@@ -4,6 +4,7 @@
 namespace Swift
 {
     struct BoundingSphere;
+    class JobSystem;
 }
 
 namespace Swift
@@ -24,6 +25,28 @@ namespace Swift
             const Frustum& frustum,
             const BoundingSphere& sphere,
             const glm::mat4& worldTransform);
+        // Tests the objects in [first, last) several at a time with the widest SIMD the build
+        // targets, and writes the indices of those inside the frustum to the front of
+        // visibleIndices, which needs room for last - first entries. Returns how many were written.
+        u32 CullBounds(
+            const Frustum& frustum,
+            const BoundsSoA& bounds,
+            u32 first,
+            u32 last,
+            std::span<u32> visibleIndices);
+        u32 CullBounds(
+            const Frustum& frustum,
+            const BoundsSoA& bounds,
+            std::span<u32> visibleIndices);
+        // Culls ranges of grainSize objects as separate jobs, then calls build once per range with
+        // the indices it kept and the slot the first of them takes in the merged list, so ranges
+        // write their draws straight into place. Returns how many objects are visible in total.
+        u32 CullAndBuild(
+            JobSystem& jobSystem,
+            const Frustum& frustum,
+            const BoundsSoA& bounds,
+            u32 grainSize,
+            const std::function<void(u32 firstSlot, std::span<const u32> indices)>& build);
 
         inline glm::vec3 GetScaleFromMatrix(const glm::mat4& matrix)
         {
@@ -0,0 +1,49 @@
+#pragma once
+
+namespace Swift::DDS
+{
+    // Layout of a DDS file's header, parsed from memory so a mapped file is only opened once.
+    // Layers are stored one after another, each with its full mip chain.
+    class Header
+    {
+    public:
+        u32 Width() const { return width; }
+        u32 Height() const { return height; }
+        u32 MipLevels() const { return mipLevels; }
+        // Cubemaps count each face as a layer
+        u32 ArraySize() const { return arraySize; }
+        bool IsCubemap() const { return bCubemap; }
+        vk::Format GetFormat() const { return format; }
+
+        // Offsets are from the start of the file. Mip offsets and sizes are for the first layer,
+        // the data size covers every layer.
+        u32 DataOffset() const { return dataOffset; }
+        u64 DataSize() const;
+        u64 MipOffset(u32 mipLevel) const;
+        u64 MipSize(u32 mipLevel) const;
+
+        vk::Extent3D GetVulkanExtent() const { return {width, height, depth}; }
+        VkImageCreateInfo GetVulkanImageCreateInfo(vk::ImageUsageFlags usage) const;
+        // The image is left for the caller to fill in once it is created
+        VkImageViewCreateInfo GetVulkanImageViewCreateInfo() const;
+
+    private:
+        friend std::optional<Header> ReadHeader(std::span<const char> data);
+
+        u32 width{};
+        u32 height{};
+        u32 depth = 1;
+        u32 mipLevels = 1;
+        u32 arraySize = 1;
+        bool bCubemap = false;
+        vk::Format format = vk::Format::eUndefined;
+        u32 dataOffset{};
+        // Bytes per 4x4 block for compressed formats, per texel otherwise
+        u32 blockSize{};
+        bool bCompressed = false;
+    };
+
+    // Empty when the data is not a DDS file, uses a format Vulkan cannot sample, or is too short
+    // to hold every mip the header describes
+    std::optional<Header> ReadHeader(std::span<const char> data);
+} // namespace Swift::DDS
@@ -1,7 +1,29 @@
 #pragma once
 
+// Read-only view of a whole file mapped into memory
+struct MappedFile
+{
+    const char* data{};
+    u64 size{};
+#ifdef SWIFT_WINDOWS
+    void* fileHandle{};
+    void* mappingHandle{};
+#endif
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
 class FileIO 
 {
 public:
     static std::vector<char> ReadBinaryFile(const std::string_view filePath);
+    // Writes to a sibling file first and renames it over the target, so a crash mid write never
+    // leaves a truncated file behind
+    static bool WriteBinaryFile(
+        const std::string_view filePath,
+        std::span<const char> data);
+    // Maps the file and hints the OS to read it ahead sequentially. Returns an empty mapping on
+    // failure
+    static MappedFile MapFile(const std::string_view filePath);
+    static void UnmapFile(MappedFile& file);
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+namespace Swift
+{
+    // Counts the jobs submitted against it that have not finished yet. Jobs submitted with it as
+    // their dependency start once it drops to zero. Reuse it only after it has been waited on.
+    class JobCounter
+    {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<u32> pending = 0;
+        mutable std::mutex mutex;
+        // Jobs depending on this counter, pushed once it drops to zero
+        std::vector<std::function<void()>> continuations;
+    };
+
+    // Fixed set of worker threads, each with its own job deque. Owners pop their newest job, idle
+    // workers steal the oldest job of another deque, so split work spreads out while each worker
+    // keeps going on the data it touched last. Threads that are not workers push into a shared
+    // deque and help run jobs while they wait.
+    class JobSystem
+    {
+    public:
+        explicit JobSystem(u32 threadCount);
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // The counter is incremented before the job is queued and decremented when it finishes
+        void Submit(
+            std::function<void()> job,
+            JobCounter* counter = nullptr,
+            JobCounter* dependency = nullptr);
+        // Runs other jobs on the calling thread until the counter drops to zero, and sleeps while
+        // there are none to run
+        void Wait(const JobCounter& counter);
+
+        // Calls function on disjoint ranges covering [0, count), none larger than grainSize, and
+        // returns once all of them ran. Ranges are split in halves, so stolen work stays large.
+        void ParallelFor(
+            u32 count,
+            u32 grainSize,
+            const std::function<void(u32 first, u32 last)>& function);
+
+        u32 GetThreadCount() const { return static_cast<u32>(threads.size()); }
+
+    private:
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+        };
+
+        void Push(std::function<void()> job);
+        bool RunOne();
+        void Finish(JobCounter* counter);
+        void SubmitRange(
+            u32 first,
+            u32 last,
+            u32 grainSize,
+            const std::function<void(u32 first, u32 last)>& function,
+            JobCounter& counter);
+        void WorkerLoop(u32 workerIndex);
+
+        std::vector<std::thread> threads;
+        // One per worker, the last one is shared by all other threads
+        std::vector<std::unique_ptr<JobQueue>> queues;
+        std::atomic<u32> queuedJobs = 0;
+        std::mutex sleepMutex;
+        std::condition_variable condition;
+        bool bStopping = false;
+    };
+} // namespace Swift
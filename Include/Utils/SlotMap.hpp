@@ -0,0 +1,130 @@
+#pragma once
+#include "Vulkan/VulkanConstants.hpp"
+
+namespace Swift
+{
+    // Dense storage addressed by generational handles. A handle packs the slot index in the low
+    // 16 bits and the slot's generation above it. Erasing a slot bumps its generation and puts the
+    // index on a free list, so indices are recycled while stale handles stop validating. The
+    // generation wraps after MaxGeneration reuses of a slot, after which a stale handle to it
+    // validates again.
+    template <
+        typename T,
+        u32 GenerationBits = 16>
+    struct SlotMap
+    {
+        static_assert(GenerationBits > 0 && GenerationBits <= 16);
+        static constexpr u32 IndexBits = 16;
+        static constexpr u32 IndexMask = (1u << IndexBits) - 1;
+        // Slot indices double as bindless array elements, which hold one less entry than the
+        // index bits can address
+        static constexpr u32 MaxSlots = Vulkan::Constants::MaxSamplerDescriptors;
+        // The all ones generation is skipped so no live handle can ever equal InvalidHandle
+        static constexpr u32 MaxGeneration = (1u << GenerationBits) - 1;
+
+        std::vector<T> values;
+        std::vector<u32> generations;
+        std::vector<bool> alive;
+        std::vector<u32> freeIndices;
+
+        static u32 GetIndex(const u32 handle) { return handle & IndexMask; }
+        static u32 GetGeneration(const u32 handle) { return (handle >> IndexBits) & MaxGeneration; }
+
+        u32 Insert(const T& value)
+        {
+            u32 index;
+            if (!freeIndices.empty())
+            {
+                index = freeIndices.back();
+                freeIndices.pop_back();
+                values[index] = value;
+            }
+            else
+            {
+                index = static_cast<u32>(values.size());
+                assert(index < MaxSlots && "Slot map is full");
+                values.emplace_back(value);
+                generations.emplace_back(0);
+                alive.emplace_back(false);
+            }
+            alive[index] = true;
+            return HandleFromIndex(index);
+        }
+
+        // Current handle of a live slot, e.g. when only the descriptor index is known
+        u32 HandleFromIndex(const u32 index) const
+        {
+            return (generations[index] << IndexBits) | index;
+        }
+
+        bool IsAlive(const u32 index) const { return index < values.size() && alive[index]; }
+
+        bool IsValid(const u32 handle) const
+        {
+            const auto index = GetIndex(handle);
+            return index < values.size() && alive[index] &&
+                   generations[index] == GetGeneration(handle);
+        }
+
+        T& Get(const u32 handle)
+        {
+            assert(IsValid(handle) && "Stale or invalid handle");
+            return values[GetIndex(handle)];
+        }
+        const T& Get(const u32 handle) const
+        {
+            assert(IsValid(handle) && "Stale or invalid handle");
+            return values[GetIndex(handle)];
+        }
+
+        // Invalidates the handle but keeps the index reserved, e.g. until the GPU is done with it
+        void Remove(const u32 handle)
+        {
+            assert(IsValid(handle) && "Stale or invalid handle");
+            const auto index = GetIndex(handle);
+            values[index] = T{};
+            alive[index] = false;
+            generations[index] = (generations[index] + 1) % MaxGeneration;
+        }
+
+        // Hands an index invalidated by Remove back for reuse
+        void Release(const u32 index)
+        {
+            assert(!alive[index] && "Releasing a live slot");
+            freeIndices.emplace_back(index);
+        }
+
+        // Remove and Release in one go. The caller is responsible for destroying whatever the
+        // value owns first.
+        void Erase(const u32 handle)
+        {
+            Remove(handle);
+            Release(GetIndex(handle));
+        }
+
+        template <typename Function>
+        void ForEach(Function&& function)
+        {
+            for (u32 index = 0; index < values.size(); index++)
+            {
+                if (alive[index])
+                {
+                    function(values[index]);
+                }
+            }
+        }
+
+        void Clear()
+        {
+            for (u32 index = 0; index < values.size(); index++)
+            {
+                if (alive[index])
+                {
+                    Erase(HandleFromIndex(index));
+                }
+            }
+        }
+
+        u32 Size() const { return static_cast<u32>(values.size() - freeIndices.size()); }
+    };
+} // namespace Swift
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace Swift
+{
+    // Fixed set of worker threads consuming a shared FIFO of tasks
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(u32 threadCount);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename Function>
+        auto Submit(Function&& function) -> std::future<std::invoke_result_t<Function>>
+        {
+            using Result = std::invoke_result_t<Function>;
+            auto task =
+                std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+            auto future = task->get_future();
+            {
+                std::scoped_lock lock(mutex);
+                tasks.emplace_back(
+                    [task]
+                    {
+                        (*task)();
+                    });
+            }
+            condition.notify_one();
+            return future;
+        }
+
+        u32 GetThreadCount() const { return static_cast<u32>(threads.size()); }
+
+    private:
+        void WorkerLoop();
+
+        std::vector<std::thread> threads;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool bStopping = false;
+    };
+} // namespace Swift
@@ -12,4 +12,7 @@ namespace Swift::Vulkan::Constants
     constexpr u8 ImageBinding = 3;
     constexpr u16 MaxCubeSamplerDescriptors = std::numeric_limits<u16>::max();
     constexpr u8 CubeSamplerBinding = 4;
+
+    constexpr u8 TransferCommandCount = 4;
+    constexpr u8 ComputeCommandCount = 4;
 }
\ No newline at end of file
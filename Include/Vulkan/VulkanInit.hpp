@@ -6,10 +6,12 @@ namespace Swift::Vulkan::Init
 {
     Context CreateContext(const InitInfo& initInfo);
 
+    // Passing the swapchain being replaced lets the driver hand its resources over
     vk::SwapchainKHR CreateSwapchain(
         const Context& context,
         vk::Extent2D extent,
-        u32 queueIndex);
+        u32 queueIndex,
+        vk::SwapchainKHR oldSwapchain = nullptr);
 
     vk::Queue GetQueue(
         const Context& context,
@@ -37,12 +39,27 @@ namespace Swift::Vulkan::Init
         const Context& context,
         const Swapchain& swapchain);
 
+    // Offscreen stand-in for the swapchain images when running without a surface
+    std::vector<Image> CreateHeadlessImages(
+        const Context& context,
+        vk::Extent2D extent,
+        u32 imageCount);
+
+    // Buffers are exclusive to queueFamilyIndex unless concurrentQueueFamilies names more than
+    // one family, they are shared between those then
     Buffer CreateBuffer(
         const Context& context,
         u32 queueFamilyIndex,
         vk::DeviceSize size,
         vk::BufferUsageFlags bufferUsageFlags,
         bool readback,
+        std::string_view debugName,
+        std::span<const u32> concurrentQueueFamilies = {});
+
+    StagingRing CreateStagingRing(
+        const Context& context,
+        u32 queueFamilyIndex,
+        vk::DeviceSize size,
         std::string_view debugName);
 
     vk::Fence CreateFence(
@@ -52,11 +69,16 @@ namespace Swift::Vulkan::Init
     vk::Semaphore CreateSemaphore(
         const Context& context,
         std::string_view debugName);
+    vk::Semaphore CreateTimelineSemaphore(
+        const Context& context,
+        u64 initialValue,
+        std::string_view debugName);
 
     vk::CommandBuffer CreateCommandBuffer(
         const Context& context,
         vk::CommandPool commandPool,
-        std::string_view debugName);
+        std::string_view debugName,
+        vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
     vk::CommandPool CreateCommandPool(
         const Context& context,
         u32 queueIndex,
@@ -64,6 +86,11 @@ namespace Swift::Vulkan::Init
 
     vk::Sampler CreateSampler(const Context& context);
 
+    // Seeds the cache from filePath when the file was written by the same driver and GPU
+    vk::PipelineCache CreatePipelineCache(
+        const Context& context,
+        std::string_view filePath);
+
     vk::DescriptorSetLayout CreateDescriptorSetLayout(vk::Device device);
     vk::DescriptorPool CreateDescriptorPool(
         vk::Device device,
@@ -76,29 +103,75 @@ namespace Swift::Vulkan::Init
     Shader CreateGraphicsShader(
         Context context,
         BindlessDescriptor descriptor,
+        PipelineLayoutCache& layoutCache,
         bool bUsePipeline,
-        u32 pushConstantSize,
-        std::string_view vertexPath,
-        std::string_view fragmentPath,
+        std::span<char> vertexCode,
+        std::span<char> fragmentCode,
         std::string_view debugName);
 
     Shader CreateComputeShader(
         Context context,
         BindlessDescriptor descriptor,
+        PipelineLayoutCache& layoutCache,
         bool bUsePipeline,
-        u32 pushConstantSize,
-        std::string_view computePath,
+        std::span<char> computeCode,
         std::string_view debugName);
 
-    std::tuple<
+    // Also returns the dedicated staging buffer if one was needed and the barrier releasing the
+    // image from the transfer queue to dstQueueFamily, which has to be repeated on that queue.
+    // Empty when the file is missing or is not a DDS file Vulkan can sample.
+    std::optional<std::tuple<
         Image,
-        Buffer>
+        Buffer,
+        vk::ImageMemoryBarrier2>>
     CreateDDSImage(
         const Context& context,
         Queue transferQueue,
         Command transferCommand,
+        u32 dstQueueFamily,
         const std::filesystem::path& filePath,
         int maxMipLevel,
         bool loadAllMips,
+        StagingRing& stagingRing,
+        u64 ticket,
+        std::string_view debugName);
+
+    // Allocates the whole mip chain but only uploads residentMip and coarser. The view is clamped
+    // to residentMip, finer mips are filled in place later with UploadDDSMip.
+    std::optional<std::tuple<
+        Image,
+        Buffer,
+        vk::ImageMemoryBarrier2>>
+    CreateProgressiveDDSImage(
+        const Context& context,
+        Queue transferQueue,
+        Command transferCommand,
+        u32 dstQueueFamily,
+        const std::filesystem::path& filePath,
+        int residentMip,
+        StagingRing& stagingRing,
+        u64 ticket,
+        std::string_view debugName);
+
+    // Uploads a single mip of the image's DDS file into the level it already has allocated.
+    // Returns the same staging buffer and release barrier as CreateDDSImage, empty likewise.
+    std::optional<std::tuple<
+        Buffer,
+        vk::ImageMemoryBarrier2>>
+    UploadDDSMip(
+        const Context& context,
+        Queue transferQueue,
+        Command transferCommand,
+        u32 dstQueueFamily,
+        Image& image,
+        int mipLevel,
+        StagingRing& stagingRing,
+        u64 ticket);
+
+    // View over the image's whole mip chain that never samples finer than minLod
+    vk::ImageView CreateMinLodImageView(
+        const Context& context,
+        const Image& image,
+        int minLod,
         std::string_view debugName);
 } // namespace Swift::Vulkan::Init
\ No newline at end of file
@@ -3,19 +3,17 @@
 
 namespace Swift::Vulkan::Render
 {
+    // Returns u32 max when the swapchain is out of date and has to be recreated before an image
+    // can be acquired. Suboptimal images are returned and only flag the swapchain for recreation.
     u32 AcquireNextImage(
-        const Queue& queue,
         const Context& context,
         Swapchain& swapchain,
-        vk::Semaphore semaphore,
-        vk::Extent2D extent);
+        vk::Semaphore semaphore);
 
     void Present(
-        const Context& context,
         Swapchain& swapchain,
         Queue queue,
-        vk::Semaphore semaphore,
-        vk::Extent2D extent);
+        vk::Semaphore semaphore);
 
     inline Image& GetSwapchainImage(Swapchain& swapchain)
     {
@@ -27,14 +25,9 @@ namespace Swift::Vulkan::Render
         return frameData.renderSemaphore;
     }
 
-    inline vk::Semaphore& GetPresentSemaphore(FrameData& frameData)
+    inline u64& GetTimelineValue(FrameData& frameData)
     {
-        return frameData.presentSemaphore;
-    }
-
-    inline vk::Fence& GetRenderFence(FrameData& frameData)
-    {
-        return frameData.renderFence;
+        return frameData.timelineValue;
     }
 
     inline vk::CommandBuffer& GetCommandBuffer(FrameData& frameData)
@@ -47,10 +40,18 @@ namespace Swift::Vulkan::Render
         return frameData.renderCommand.commandPool;
     }
 
+    inline StateTracker& GetRenderState(FrameData& frameData)
+    {
+        return frameData.renderState;
+    }
+
     inline void BeginRendering(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         Swapchain& swapchain,
-        const bool enableDepth)
+        const bool enableDepth,
+        const vk::RenderingFlags flags = {},
+        const vk::AttachmentLoadOp depthLoadOp = vk::AttachmentLoadOp::eClear)
     {
         const auto colorAttachment = vk::RenderingAttachmentInfo()
                                          .setImageView(GetSwapchainImage(swapchain).imageView)
@@ -62,18 +63,20 @@ namespace Swift::Vulkan::Render
                                          .setImageView(swapchain.depthImage.imageView)
                                          .setClearValue(vk::ClearColorValue().setFloat32({1.f}))
                                          .setImageLayout(vk::ImageLayout::eDepthAttachmentOptimal)
-                                         .setLoadOp(vk::AttachmentLoadOp::eClear)
+                                         .setLoadOp(depthLoadOp)
                                          .setStoreOp(vk::AttachmentStoreOp::eStore);
         const auto renderingInfo =
             vk::RenderingInfo()
                 .setColorAttachments(colorAttachment)
                 .setPDepthAttachment(enableDepth ? &depthAttachment : nullptr)
                 .setLayerCount(1)
-                .setRenderArea(vk::Rect2D().setExtent(swapchain.extent));
-        commandBuffer.beginRendering(renderingInfo);
+                .setRenderArea(vk::Rect2D().setExtent(swapchain.extent))
+                .setFlags(flags);
+        commandBuffer.beginRendering(renderingInfo, context.dynamicLoader);
     }
 
     inline void BeginRendering(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         const vk::ImageView& renderImageView,
         const vk::ImageView& depthImageView,
@@ -100,39 +103,63 @@ namespace Swift::Vulkan::Render
                 .setLayerCount(layerCount)
                 .setRenderArea(vk::Rect2D().setExtent(extent))
                 .setViewMask(viewMask);
-        commandBuffer.beginRendering(renderingInfo);
+        commandBuffer.beginRendering(renderingInfo, context.dynamicLoader);
     }
 
-    inline void EndRendering(const vk::CommandBuffer commandBuffer)
+    inline void EndRendering(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer)
     {
-        commandBuffer.endRendering();
+        commandBuffer.endRendering(context.dynamicLoader);
     }
 
     inline void BindShader(
         const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
         const Context& context,
         const BindlessDescriptor& descriptor,
-        Shader shader,
+        const Shader& shader,
         const bool bUsePipelines)
     {
-        const auto it = std::ranges::find(shader.stageFlags, vk::ShaderStageFlagBits::eCompute);
-        auto pipelineBindPoint = vk::PipelineBindPoint::eCompute;
-        if (it == std::end(shader.stageFlags))
-        {
-            pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-        }
+        const auto bCompute =
+            std::ranges::contains(shader.stageFlags, vk::ShaderStageFlagBits::eCompute);
+        const auto pipelineBindPoint =
+            bCompute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+        auto& bound = bCompute ? state.compute : state.graphics;
 
         if (bUsePipelines)
         {
-            commandBuffer.bindPipeline(pipelineBindPoint, shader.pipeline);
+            if (bound.pipeline != shader.pipeline)
+            {
+                commandBuffer
+                    .bindPipeline(pipelineBindPoint, shader.pipeline, context.dynamicLoader);
+                bound.pipeline = shader.pipeline;
+            }
         }
-        else
+        else if (bound.shaders != shader.shaders)
         {
             commandBuffer.bindShadersEXT(shader.stageFlags, shader.shaders, context.dynamicLoader);
+            bound.shaders = shader.shaders;
         }
 
-        commandBuffer
-            .bindDescriptorSets(pipelineBindPoint, shader.pipelineLayout, 0, descriptor.set, {});
+        // Layouts are shared between shaders with the same push constant range, and the set stays
+        // bound as long as the layout does not change
+        if (bound.pipelineLayout != shader.pipelineLayout)
+        {
+            commandBuffer.bindDescriptorSets(
+                pipelineBindPoint,
+                shader.pipelineLayout,
+                0,
+                descriptor.set,
+                {},
+                context.dynamicLoader);
+            bound.pipelineLayout = shader.pipelineLayout;
+        }
+        if (state.pushConstantLayout != shader.pipelineLayout)
+        {
+            state.pushConstantLayout = shader.pipelineLayout;
+            state.pushConstantSize = 0;
+        }
     }
 
     // --------------------------------------------------------------------------------------------
@@ -142,45 +169,62 @@ namespace Swift::Vulkan::Render
     // --------------------------------------------------------------------------------------------
 
     inline void SetViewportAndScissor(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
         const vk::Extent2D extent)
     {
+        if (!StateTracker::Changed(state.viewportExtent, extent))
+        {
+            return;
+        }
         commandBuffer.setViewportWithCount(
-            vk::Viewport().setWidth(extent.width).setHeight(extent.height).setMaxDepth(1.f));
-        commandBuffer.setScissorWithCount(vk::Rect2D().setExtent(extent));
+            vk::Viewport().setWidth(extent.width).setHeight(extent.height).setMaxDepth(1.f),
+            context.dynamicLoader);
+        commandBuffer.setScissorWithCount(vk::Rect2D().setExtent(extent), context.dynamicLoader);
     }
 
     // --------------------------------------------------------------------------------------------
     // ---------------------------------Color Blend Attachment-------------------------------------
     // --------------------------------------------------------------------------------------------
 
-    inline void SetColorBlendDefault(
+    inline void SetColorBlendEquation(
         const Context& context,
-        const vk::CommandBuffer commandBuffer)
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
+        const vk::ColorBlendEquationEXT& colorBlendEquation)
     {
-        commandBuffer.setColorWriteMaskEXT(
-            0,
-            {vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-             vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA},
-            context.dynamicLoader);
-        bool colorBlendEnabled = false;
+        if (StateTracker::Changed(state.colorBlendEquation, colorBlendEquation))
+        {
+            commandBuffer.setColorBlendEquationEXT(0, colorBlendEquation, context.dynamicLoader);
+        }
+    }
 
-        constexpr auto colorBlendEquation =
-    vk::ColorBlendEquationEXT()
-        .setAlphaBlendOp(vk::BlendOp::eAdd)
-        .setSrcAlphaBlendFactor(vk::BlendFactor::eOne)
-        .setDstAlphaBlendFactor(vk::BlendFactor::eZero)
-        .setColorBlendOp(vk::BlendOp::eAdd)
-        .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
-        .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha);
-        commandBuffer.setColorBlendEquationEXT(0, colorBlendEquation, context.dynamicLoader);
-        commandBuffer.setColorBlendEnableEXT(0, colorBlendEnabled, context.dynamicLoader);
+    inline void SetColorBlendEnable(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
+        const bool enable)
+    {
+        if (StateTracker::Changed(state.colorBlendEnable, enable))
+        {
+            commandBuffer.setColorBlendEnableEXT(0, vk::Bool32(enable), context.dynamicLoader);
+        }
     }
 
-    inline void EnableTransparencyBlending(
+    inline void SetColorBlendDefault(
         const Context& context,
-        const vk::CommandBuffer commandBuffer)
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
+        constexpr vk::ColorComponentFlags colorWriteMask =
+            vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+            vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+        if (StateTracker::Changed(state.colorWriteMask, colorWriteMask))
+        {
+            commandBuffer.setColorWriteMaskEXT(0, colorWriteMask, context.dynamicLoader);
+        }
+
         constexpr auto colorBlendEquation =
             vk::ColorBlendEquationEXT()
                 .setAlphaBlendOp(vk::BlendOp::eAdd)
@@ -189,12 +233,14 @@ namespace Swift::Vulkan::Render
                 .setColorBlendOp(vk::BlendOp::eAdd)
                 .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
                 .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha);
-        commandBuffer.setColorBlendEquationEXT(0, colorBlendEquation, context.dynamicLoader);
-        commandBuffer.setColorBlendEnableEXT(0, true, context.dynamicLoader);
+        SetColorBlendEquation(context, commandBuffer, state, colorBlendEquation);
+        SetColorBlendEnable(context, commandBuffer, state, false);
     }
-    inline void DisableBlending(
+
+    inline void EnableTransparencyBlending(
         const Context& context,
-        const vk::CommandBuffer commandBuffer)
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
         constexpr auto colorBlendEquation =
             vk::ColorBlendEquationEXT()
@@ -204,25 +250,43 @@ namespace Swift::Vulkan::Render
                 .setColorBlendOp(vk::BlendOp::eAdd)
                 .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
                 .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha);
-        commandBuffer.setColorBlendEquationEXT(0, colorBlendEquation, context.dynamicLoader);
-        commandBuffer.setColorBlendEnableEXT(0, 0, nullptr, context.dynamicLoader);
+        SetColorBlendEquation(context, commandBuffer, state, colorBlendEquation);
+        SetColorBlendEnable(context, commandBuffer, state, true);
+    }
+    inline void DisableBlending(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
+    {
+        SetColorBlendEnable(context, commandBuffer, state, false);
     }
 
     // --------------------------------------------------------------------------------------------
     // -------------------------------------Input Assembly-----------------------------------------
     // --------------------------------------------------------------------------------------------
 
-    inline void SetInputAssemblyDefault(const vk::CommandBuffer commandBuffer)
+    inline void SetPrimitiveTopology(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
+        const vk::PrimitiveTopology topology)
     {
-        commandBuffer.setPrimitiveTopology(vk::PrimitiveTopology::eTriangleList);
-        commandBuffer.setPrimitiveRestartEnable(false);
+        if (StateTracker::Changed(state.primitiveTopology, topology))
+        {
+            commandBuffer.setPrimitiveTopology(topology, context.dynamicLoader);
+        }
     }
 
-    inline void SetPrimitiveTopology(
+    inline void SetInputAssemblyDefault(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
-        const vk::PrimitiveTopology topology)
+        StateTracker& state)
     {
-        commandBuffer.setPrimitiveTopology(topology);
+        SetPrimitiveTopology(context, commandBuffer, state, vk::PrimitiveTopology::eTriangleList);
+        if (StateTracker::Changed(state.primitiveRestartEnable, false))
+        {
+            commandBuffer.setPrimitiveRestartEnable(false, context.dynamicLoader);
+        }
     }
 
     // --------------------------------------------------------------------------------------------
@@ -231,80 +295,149 @@ namespace Swift::Vulkan::Render
 
     inline void SetVertexInputDefault(
         const Context& context,
-        const vk::CommandBuffer commandBuffer)
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
+        // Vertices are always pulled from buffers, so the empty input state never changes
+        if (state.bVertexInputSet)
+        {
+            return;
+        }
         commandBuffer.setVertexInputEXT({}, {}, context.dynamicLoader);
+        state.bVertexInputSet = true;
     }
 
     // --------------------------------------------------------------------------------------------
     // -------------------------------------Depth Stencil------------------------------------------
     // --------------------------------------------------------------------------------------------
 
-    inline void SetDepthStencilDefault(const vk::CommandBuffer commandBuffer)
+    inline void SetDepthCompareOp(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
+        const vk::CompareOp compareOp)
     {
-        commandBuffer.setDepthTestEnable(true);
-        commandBuffer.setDepthCompareOp(vk::CompareOp::eLess);
-        commandBuffer.setDepthWriteEnable(true);
-        commandBuffer.setStencilTestEnable(false);
+        if (StateTracker::Changed(state.depthCompareOp, compareOp))
+        {
+            commandBuffer.setDepthCompareOp(compareOp, context.dynamicLoader);
+        }
     }
 
-    inline void DisableDepth(const vk::CommandBuffer commandBuffer)
+    inline void SetDepthTest(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
+        const bool enableTest,
+        const bool enableWrite)
     {
-        commandBuffer.setDepthTestEnable(false);
-        commandBuffer.setDepthWriteEnable(false);
+        if (StateTracker::Changed(state.depthTestEnable, enableTest))
+        {
+            commandBuffer.setDepthTestEnable(enableTest, context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.depthWriteEnable, enableWrite))
+        {
+            commandBuffer.setDepthWriteEnable(enableWrite, context.dynamicLoader);
+        }
     }
 
-    inline void EnableDepth(const vk::CommandBuffer commandBuffer)
+    inline void SetDepthStencilDefault(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
-        commandBuffer.setDepthTestEnable(true);
-        commandBuffer.setDepthCompareOp(vk::CompareOp::eLess);
-        commandBuffer.setDepthWriteEnable(true);
+        SetDepthTest(context, commandBuffer, state, true, true);
+        SetDepthCompareOp(context, commandBuffer, state, vk::CompareOp::eLess);
+        if (StateTracker::Changed(state.stencilTestEnable, false))
+        {
+            commandBuffer.setStencilTestEnable(false, context.dynamicLoader);
+        }
     }
 
-    inline void SetDepthCompareOp(
+    inline void DisableDepth(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
-        const vk::CompareOp compareOp)
+        StateTracker& state)
+    {
+        SetDepthTest(context, commandBuffer, state, false, false);
+    }
+
+    inline void EnableDepth(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
-        commandBuffer.setDepthCompareOp(compareOp);
+        SetDepthTest(context, commandBuffer, state, true, true);
+        SetDepthCompareOp(context, commandBuffer, state, vk::CompareOp::eLess);
     }
 
     // --------------------------------------------------------------------------------------------
     // -------------------------------------Rasterization------------------------------------------
     // --------------------------------------------------------------------------------------------
 
-    inline void SetRasterizerDefault(
-        const Context& context,
-        const vk::CommandBuffer commandBuffer)
-    {
-        commandBuffer.setRasterizerDiscardEnable(false);
-        commandBuffer.setRasterizationSamplesEXT(
-            vk::SampleCountFlagBits::e1,
-            context.dynamicLoader);
-        commandBuffer.setLineWidth(1.f);
-        commandBuffer.setPolygonModeEXT(vk::PolygonMode::eFill, context.dynamicLoader);
-        commandBuffer.setCullMode(vk::CullModeFlagBits::eBack);
-        commandBuffer.setFrontFace(vk::FrontFace::eCounterClockwise);
-        commandBuffer.setDepthBias(0, 0, 0);
-        commandBuffer.setDepthBiasEnable(false);
-    }
     inline void SetCullMode(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
-        const vk::CullModeFlagBits mode)
+        StateTracker& state,
+        const vk::CullModeFlags mode)
     {
-        commandBuffer.setCullMode(mode);
+        if (StateTracker::Changed(state.cullMode, mode))
+        {
+            commandBuffer.setCullMode(mode, context.dynamicLoader);
+        }
     }
     inline void SetFrontFace(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
         const vk::FrontFace frontFace)
     {
-        commandBuffer.setFrontFace(frontFace);
+        if (StateTracker::Changed(state.frontFace, frontFace))
+        {
+            commandBuffer.setFrontFace(frontFace, context.dynamicLoader);
+        }
     }
     inline void SetPolygonMode(
         const Context& context,
         const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
         const vk::PolygonMode polygonMode)
     {
-        commandBuffer.setPolygonModeEXT(polygonMode, context.dynamicLoader);
+        if (StateTracker::Changed(state.polygonMode, polygonMode))
+        {
+            commandBuffer.setPolygonModeEXT(polygonMode, context.dynamicLoader);
+        }
+    }
+
+    inline void SetRasterizerDefault(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
+    {
+        if (StateTracker::Changed(state.rasterizerDiscardEnable, false))
+        {
+            commandBuffer.setRasterizerDiscardEnable(false, context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.rasterizationSamples, vk::SampleCountFlagBits::e1))
+        {
+            commandBuffer.setRasterizationSamplesEXT(
+                vk::SampleCountFlagBits::e1,
+                context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.lineWidth, 1.f))
+        {
+            commandBuffer.setLineWidth(1.f, context.dynamicLoader);
+        }
+        SetPolygonMode(context, commandBuffer, state, vk::PolygonMode::eFill);
+        SetCullMode(context, commandBuffer, state, vk::CullModeFlagBits::eBack);
+        SetFrontFace(context, commandBuffer, state, vk::FrontFace::eCounterClockwise);
+        if (StateTracker::Changed(state.depthBias, {0.f, 0.f, 0.f}))
+        {
+            commandBuffer.setDepthBias(0, 0, 0, context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.depthBiasEnable, false))
+        {
+            commandBuffer.setDepthBiasEnable(false, context.dynamicLoader);
+        }
     }
 
     // --------------------------------------------------------------------------------------------
@@ -313,38 +446,52 @@ namespace Swift::Vulkan::Render
 
     inline void SetMultiSampleDefault(
         const Context& context,
-        const vk::CommandBuffer commandBuffer)
+        const vk::CommandBuffer commandBuffer,
+        StateTracker& state)
     {
-        commandBuffer.setSampleMaskEXT(
-            vk::SampleCountFlagBits::e1,
-            0xFFFFFFFF,
-            context.dynamicLoader);
-        commandBuffer.setAlphaToCoverageEnableEXT(false, context.dynamicLoader);
-        commandBuffer.setAlphaToOneEnableEXT(false, context.dynamicLoader);
+        if (StateTracker::Changed(state.sampleMask, vk::SampleMask(0xFFFFFFFF)))
+        {
+            commandBuffer.setSampleMaskEXT(
+                vk::SampleCountFlagBits::e1,
+                0xFFFFFFFF,
+                context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.alphaToCoverageEnable, false))
+        {
+            commandBuffer.setAlphaToCoverageEnableEXT(false, context.dynamicLoader);
+        }
+        if (StateTracker::Changed(state.alphaToOneEnable, false))
+        {
+            commandBuffer.setAlphaToOneEnableEXT(false, context.dynamicLoader);
+        }
     }
 
     inline void SetPipelineDefault(
         const Context& context,
         const vk::CommandBuffer commandBuffer,
+        StateTracker& state,
         const vk::Extent2D extent,
         const bool bUsePipeline)
     {
         if (bUsePipeline)
         {
-            const auto viewport = vk::Viewport()
-                                      .setWidth(float(extent.width))
-                                      .setHeight(float(extent.height))
-                                      .setMinDepth(0.f)
-                                      .setMaxDepth(1.f);
-            commandBuffer.setViewport(0, viewport);
-            commandBuffer.setScissor(0, vk::Rect2D().setExtent(extent));
+            if (state.viewportExtent != extent)
+            {
+                const auto viewport = vk::Viewport()
+                                          .setWidth(float(extent.width))
+                                          .setHeight(float(extent.height))
+                                          .setMinDepth(0.f)
+                                          .setMaxDepth(1.f);
+                commandBuffer.setViewport(0, viewport, context.dynamicLoader);
+                commandBuffer.setScissor(0, vk::Rect2D().setExtent(extent), context.dynamicLoader);
+            }
         }
-        SetViewportAndScissor(commandBuffer, extent);
-        SetColorBlendDefault(context, commandBuffer);
-        SetInputAssemblyDefault(commandBuffer);
-        SetVertexInputDefault(context, commandBuffer);
-        SetDepthStencilDefault(commandBuffer);
-        SetRasterizerDefault(context, commandBuffer);
-        SetMultiSampleDefault(context, commandBuffer);
+        SetViewportAndScissor(context, commandBuffer, state, extent);
+        SetColorBlendDefault(context, commandBuffer, state);
+        SetInputAssemblyDefault(context, commandBuffer, state);
+        SetVertexInputDefault(context, commandBuffer, state);
+        SetDepthStencilDefault(context, commandBuffer, state);
+        SetRasterizerDefault(context, commandBuffer, state);
+        SetMultiSampleDefault(context, commandBuffer, state);
     }
 } // namespace Swift::Vulkan::Render
@@ -9,7 +9,9 @@ namespace Swift::Vulkan
         vk::PhysicalDevice gpu;
         vk::Device device;
         VmaAllocator allocator{};
+        // Device level function table, used for extensions and everything recorded per draw
         vk::detail::DispatchLoaderDynamic dynamicLoader;
+        vk::PipelineCache pipelineCache;
 
         operator vk::Device() const { return device; }
 
@@ -43,11 +45,20 @@ namespace Swift::Vulkan
             this->dynamicLoader = dynamicLoader;
             return *this;
         }
+        Context& SetPipelineCache(const vk::PipelineCache& pipelineCache)
+        {
+            this->pipelineCache = pipelineCache;
+            return *this;
+        }
 
         void Destroy() const
         {
-            vkDestroySurfaceKHR(instance, surface, nullptr);
+            if (surface)
+            {
+                vkDestroySurfaceKHR(instance, surface, nullptr);
+            }
             vmaDestroyAllocator(allocator);
+            device.destroy(pipelineCache);
             device.destroy();
             instance.destroy();
         };
@@ -80,6 +91,7 @@ namespace Swift::Vulkan
         VmaAllocation imageAllocation{};
         vk::ImageLayout currentLayout = vk::ImageLayout::eUndefined;
         vk::Extent3D extent{};
+        u32 mipLevels = 1;
         int minLod = 0.0f;
         int maxLod = 0.0f;
         std::string uri;
@@ -116,6 +128,11 @@ namespace Swift::Vulkan
             this->extent = vk::Extent3D(extent, 1);
             return *this;
         }
+        Image& SetMipLevels(const u32 mipLevels)
+        {
+            this->mipLevels = mipLevels;
+            return *this;
+        }
         Image& SetMinLod(const float minLod)
         {
             this->minLod = minLod;
@@ -193,6 +210,90 @@ namespace Swift::Vulkan
         }
     };
 
+    // Persistently mapped staging buffer that is sub-allocated as a ring. Head and tail are
+    // free-running byte positions, every allocation is tagged with the ticket of the submit that
+    // reads it and its space is reclaimed once that ticket has completed.
+    struct StagingRing
+    {
+        Buffer buffer;
+        void* mapped{};
+        u64 capacity{};
+        u64 head{};
+        u64 tail{};
+        std::deque<std::pair<
+            u64,
+            u64>>
+            inFlight;
+
+        StagingRing& SetBuffer(const Buffer& buffer)
+        {
+            this->buffer = buffer;
+            return *this;
+        }
+        StagingRing& SetMapped(void* mapped)
+        {
+            this->mapped = mapped;
+            return *this;
+        }
+        StagingRing& SetCapacity(const u64 capacity)
+        {
+            this->capacity = capacity;
+            return *this;
+        }
+
+        // Returns the offset into the buffer or nothing if the ring is out of space
+        std::optional<u64> Allocate(
+            const u64 size,
+            const u64 alignment,
+            const u64 ticket)
+        {
+            if (size > capacity)
+            {
+                return std::nullopt;
+            }
+            auto position = (head + alignment - 1) & ~(alignment - 1);
+            // Allocations never wrap, skip to the start of the next lap instead
+            if (position % capacity + size > capacity)
+            {
+                position = (position / capacity + 1) * capacity;
+            }
+            if (position + size - tail > capacity)
+            {
+                return std::nullopt;
+            }
+            head = position + size;
+            if (!inFlight.empty() && inFlight.back().first == ticket)
+            {
+                inFlight.back().second = head;
+            }
+            else
+            {
+                inFlight.emplace_back(ticket, head);
+            }
+            return position % capacity;
+        }
+
+        void Reclaim(const u64 completedTicket)
+        {
+            while (!inFlight.empty() && inFlight.front().first <= completedTicket)
+            {
+                tail = inFlight.front().second;
+                inFlight.pop_front();
+            }
+        }
+
+        void Destroy(const Context& context)
+        {
+            if (mapped)
+            {
+                vmaUnmapMemory(context.allocator, buffer.allocation);
+                mapped = nullptr;
+            }
+            buffer.Destroy(context);
+            inFlight.clear();
+        }
+    };
+
     struct Swapchain
     {
         vk::SwapchainKHR swapchain;
@@ -200,6 +301,9 @@ namespace Swift::Vulkan
         u32 imageIndex = 0;
         vk::Extent2D extent;
         Image depthImage;
+        // Set once the swapchain no longer matches the surface. Suboptimal images can still be
+        // presented, so it is only replaced before the next acquire.
+        bool bRecreate{};
 
         operator vk::SwapchainKHR() const { return swapchain; }
 
@@ -231,8 +335,17 @@ namespace Swift::Vulkan
 
         void Destroy(const Context& context)
         {
-            context.device.destroySwapchainKHR(swapchain);
             depthImage.Destroy(context);
+            // Headless images are owned by us, swapchain images by the swapchain
+            if (!swapchain)
+            {
+                for (auto& image : images)
+                {
+                    image.Destroy(context);
+                }
+                return;
+            }
+            context.device.destroySwapchainKHR(swapchain);
             for (auto& image : images)
             {
                 image.DestroyView(context);
@@ -269,22 +382,175 @@ namespace Swift::Vulkan
         }
     };
 
+    // What was last recorded into a command buffer, so binds and dynamic state that would not
+    // change anything are skipped. Reset whenever the command buffer starts recording again or
+    // something outside of Swift records into it.
+    struct StateTracker
+    {
+        struct BoundShader
+        {
+            vk::Pipeline pipeline;
+            std::vector<vk::ShaderEXT> shaders;
+            vk::PipelineLayout pipelineLayout;
+        };
+        BoundShader graphics;
+        BoundShader compute;
+
+        // Push constants stay valid until a shader with a different layout is bound
+        vk::PipelineLayout pushConstantLayout;
+        u32 pushConstantSize{};
+        std::array<char, 256> pushConstants{};
+
+        std::optional<vk::Extent2D> viewportExtent;
+        std::optional<vk::ColorComponentFlags> colorWriteMask;
+        std::optional<vk::ColorBlendEquationEXT> colorBlendEquation;
+        std::optional<bool> colorBlendEnable;
+        std::optional<vk::PrimitiveTopology> primitiveTopology;
+        std::optional<bool> primitiveRestartEnable;
+        bool bVertexInputSet{};
+        std::optional<bool> depthTestEnable;
+        std::optional<bool> depthWriteEnable;
+        std::optional<vk::CompareOp> depthCompareOp;
+        std::optional<bool> stencilTestEnable;
+        std::optional<bool> rasterizerDiscardEnable;
+        std::optional<vk::SampleCountFlagBits> rasterizationSamples;
+        std::optional<float> lineWidth;
+        std::optional<vk::PolygonMode> polygonMode;
+        std::optional<vk::CullModeFlags> cullMode;
+        std::optional<vk::FrontFace> frontFace;
+        std::optional<std::array<
+            float,
+            3>>
+            depthBias;
+        std::optional<bool> depthBiasEnable;
+        std::optional<vk::SampleMask> sampleMask;
+        std::optional<bool> alphaToCoverageEnable;
+        std::optional<bool> alphaToOneEnable;
+
+        void Reset() { *this = StateTracker(); }
+
+        // Stores the value and returns true if it differs from what was last recorded
+        template <typename T>
+        static bool Changed(
+            std::optional<T>& recorded,
+            const T& value)
+        {
+            if (recorded == value)
+            {
+                return false;
+            }
+            recorded = value;
+            return true;
+        }
+
+        // Returns the offset and size of the bytes that differ from what is already pushed
+        std::pair<
+            u32,
+            u32>
+        UpdatePushConstants(
+            const vk::PipelineLayout layout,
+            const void* data,
+            const u32 size)
+        {
+            assert(size <= pushConstants.size() && "Push constant block is too large");
+            if (layout != pushConstantLayout)
+            {
+                pushConstantLayout = layout;
+                pushConstantSize = 0;
+            }
+            // Push constant ranges have to start and end on a multiple of four bytes
+            const auto bytes = static_cast<const char*>(data);
+            const auto knownSize = std::min(size, pushConstantSize);
+            u32 begin = 0;
+            while (begin + 4 <= knownSize &&
+                   std::memcmp(&pushConstants[begin], bytes + begin, 4) == 0)
+            {
+                begin += 4;
+            }
+            auto end = size;
+            if (size <= pushConstantSize && size % 4 == 0)
+            {
+                while (end > begin && std::memcmp(&pushConstants[end - 4], bytes + end - 4, 4) == 0)
+                {
+                    end -= 4;
+                }
+            }
+            std::memcpy(&pushConstants[begin], bytes + begin, end - begin);
+            pushConstantSize = std::max(pushConstantSize, size);
+            return {begin, end - begin};
+        }
+    };
+
+    // Secondary command buffers a parallel recording worker allocated from its own pool, the
+    // first usedCount of them are recorded this frame
+    struct WorkerCommands
+    {
+        vk::CommandPool commandPool;
+        std::vector<vk::CommandBuffer> commandBuffers;
+        u32 usedCount{};
+    };
+
     struct FrameData
     {
         vk::Semaphore renderSemaphore;
-        vk::Semaphore presentSemaphore;
-        vk::Fence renderFence;
+        // Graphics timeline value the last submission of this slot signals
+        u64 timelineValue{};
         Command renderCommand;
+        StateTracker renderState;
+        // One pool per parallel recording worker, so a pool is never used by two threads at once.
+        // The pools are reset once the frame slot is reused and their buffers handed out again.
+        std::vector<WorkerCommands> workerCommands;
 
         void Destroy(const Context& context)
         {
-            context.device.destroy(renderFence);
             context.device.destroy(renderSemaphore);
-            context.device.destroy(presentSemaphore);
             renderCommand.Destroy(context);
+            for (auto& worker : workerCommands)
+            {
+                context.device.destroy(worker.commandPool);
+            }
         }
     };
 
+    // Destroys objects once the GPU work that may still reference them has retired. Entries are
+    // keyed by a monotonically increasing value such as the frame number. Any thread may push.
+    struct DeletionQueue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<
+            u64,
+            std::function<void()>>>
+            deletors;
+
+        void Push(
+            const u64 value,
+            std::function<void()>&& deletor)
+        {
+            std::scoped_lock lock(mutex);
+            deletors.emplace_back(value, std::move(deletor));
+        }
+
+        void Flush(const u64 completedValue)
+        {
+            // Deletors run without the lock, since they may take locks whose holders push here
+            std::vector<std::function<void()>> retired;
+            {
+                std::scoped_lock lock(mutex);
+                while (!deletors.empty() && deletors.front().first <= completedValue)
+                {
+                    retired.emplace_back(std::move(deletors.front().second));
+                    deletors.pop_front();
+                }
+            }
+            for (auto& deletor : retired)
+            {
+                deletor();
+            }
+        }
+
+        void FlushAll() { Flush(std::numeric_limits<u64>::max()); }
+    };
+
     struct BindlessDescriptor
     {
         vk::DescriptorSetLayout setLayout;
@@ -315,12 +581,33 @@ namespace Swift::Vulkan
         }
     };
 
+    // Shaders with the same push constant range share a layout, so the cache owns them
+    struct PipelineLayoutCache
+    {
+        std::unordered_map<
+            u64,
+            vk::PipelineLayout>
+            layouts;
+        // Shaders may be compiled on several threads at once
+        std::mutex mutex;
+
+        void Destroy(const Context& context) const
+        {
+            for (const auto& layout : layouts | std::views::values)
+            {
+                context.device.destroy(layout);
+            }
+        }
+    };
+
     struct Shader
     {
         std::vector<vk::ShaderEXT> shaders;
         std::vector<vk::ShaderStageFlagBits> stageFlags;
         vk::Pipeline pipeline;
         vk::PipelineLayout pipelineLayout;
+        // Reflected from the SPIR-V, stage flags are only the stages that declare the block
+        vk::PushConstantRange pushConstantRange;
 
         Shader& SetShaders(const std::vector<vk::ShaderEXT>& shaders)
         {
@@ -342,6 +629,11 @@ namespace Swift::Vulkan
             this->stageFlags = stage;
             return *this;
         }
+        Shader& SetPushConstantRange(const vk::PushConstantRange& pushConstantRange)
+        {
+            this->pushConstantRange = pushConstantRange;
+            return *this;
+        }
 
         void Destroy(const Context& context) const
         {
@@ -350,7 +642,6 @@ namespace Swift::Vulkan
                 context.device.destroy(shader, nullptr, context.dynamicLoader);
             }
             context.device.destroy(pipeline, nullptr, context.dynamicLoader);
-            context.device.destroy(pipelineLayout);
         }
     };
 
@@ -358,7 +649,12 @@ namespace Swift::Vulkan
     {
         Queue queue;
         Command command;
-        vk::Fence fence;
+        // Signalled with the ticket of each transfer submitted from this thread
+        vk::Semaphore timeline;
+        u64 ticket{};
+        StagingRing stagingRing;
+        // Uploads too large for the staging ring, destroyed after each transfer
+        std::vector<Buffer> stagingBuffers;
 
         Thread& SetQueue(const Queue queue)
         {
@@ -370,15 +666,26 @@ namespace Swift::Vulkan
             this->command = command;
             return *this;
         }
-        Thread& SetFence(const vk::Fence& fence)
+        Thread& SetTimeline(const vk::Semaphore& timeline)
+        {
+            this->timeline = timeline;
+            return *this;
+        }
+        Thread& SetStagingRing(const StagingRing& stagingRing)
         {
-            this->fence = fence;
+            this->stagingRing = stagingRing;
             return *this;
         }
         void Destroy(const Context& context)
         {
             command.Destroy(context);
-            context.device.destroy(fence);
+            context.device.destroy(timeline);
+            stagingRing.Destroy(context);
+            for (const auto& buffer : stagingBuffers)
+            {
+                buffer.Destroy(context);
+            }
+            stagingBuffers.clear();
         }
     };
 } // namespace Swift::Vulkan
\ No newline at end of file
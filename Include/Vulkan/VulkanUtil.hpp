@@ -6,10 +6,11 @@ namespace Swift::Vulkan
 {
     struct Context;
 }
-namespace dds
+namespace Swift::DDS
 {
-    struct Header;
+    class Header;
 }
+struct MappedFile;
 namespace Swift::Vulkan::Util
 {
     std::vector<u32> GetQueueFamilyIndices(
@@ -33,7 +34,35 @@ namespace Swift::Vulkan::Util
         return capabilities.minImageCount + 1;
     }
 
-    void HandleSubOptimalSwapchain(
+    // Surfaces reporting a current extent only accept that one, others accept any extent within
+    // their limits. A minimized window may leave either at 0, which no swapchain can be made with.
+    inline vk::Extent2D GetSwapchainExtent(
+        const vk::PhysicalDevice gpu,
+        const vk::SurfaceKHR surface,
+        const vk::Extent2D requestedExtent)
+    {
+        const auto [result, capabilities] = gpu.getSurfaceCapabilitiesKHR(surface);
+        VK_ASSERT(result, "Failed to get surface capabilities");
+        if (capabilities.currentExtent.width != std::numeric_limits<u32>::max())
+        {
+            return capabilities.currentExtent;
+        }
+        return vk::Extent2D(
+            std::clamp(
+                requestedExtent.width,
+                capabilities.minImageExtent.width,
+                capabilities.maxImageExtent.width),
+            std::clamp(
+                requestedExtent.height,
+                capabilities.minImageExtent.height,
+                capabilities.maxImageExtent.height));
+    }
+
+    // Replaces the swapchain and depth image without waiting on the device. The old swapchain is
+    // returned since frames in flight may still use it, the caller destroys it once they retire.
+    // The extent is clamped to what the surface supports, it must not end up 0.
+    [[nodiscard]]
+    Swapchain RecreateSwapchain(
         u32 graphicsFamily,
         const Context& context,
         Swapchain& swapchain,
@@ -53,6 +82,33 @@ namespace Swift::Vulkan::Util
         vk::PipelineStageFlags2 signalStageMask,
         vk::Fence fence);
 
+    void SubmitQueue(
+        vk::Queue queue,
+        vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+        vk::ArrayProxy<const vk::SemaphoreSubmitInfo> waitInfos,
+        vk::ArrayProxy<const vk::SemaphoreSubmitInfo> signalInfos,
+        vk::Fence fence);
+
+    inline u64 GetSemaphoreValue(
+        const vk::Device& device,
+        const vk::Semaphore semaphore)
+    {
+        const auto [result, value] = device.getSemaphoreCounterValue(semaphore);
+        VK_ASSERT(result, "Failed to get semaphore counter value");
+        return value;
+    }
+    inline void WaitSemaphore(
+        const vk::Device& device,
+        const vk::Semaphore semaphore,
+        const u64 value,
+        const u64 timeout = std::numeric_limits<u64>::max())
+    {
+        const auto waitInfo = vk::SemaphoreWaitInfo().setSemaphores(semaphore).setValues(value);
+        [[maybe_unused]]
+        const auto result = device.waitSemaphores(waitInfo, timeout);
+        VK_ASSERT(result, "Failed to wait semaphore");
+    }
+
     inline void ResetFence(
         const vk::Device& device,
         const vk::Fence fence)
@@ -82,6 +138,22 @@ namespace Swift::Vulkan::Util
         const auto beginResult = commandBuffer.begin(beginInfo);
         VK_ASSERT(beginResult, "Failed to begin command buffer");
     }
+    // For secondary command buffers executed inside a dynamic rendering instance. Their pool is
+    // reset as a whole, so the buffer is not reset here.
+    inline void BeginSecondaryCommand(
+        const vk::CommandBuffer commandBuffer,
+        const vk::CommandBufferInheritanceRenderingInfo& renderingInfo)
+    {
+        const auto inheritanceInfo = vk::CommandBufferInheritanceInfo().setPNext(&renderingInfo);
+        const auto beginInfo = vk::CommandBufferBeginInfo()
+                                   .setFlags(
+                                       vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+                                       vk::CommandBufferUsageFlagBits::eRenderPassContinue)
+                                   .setPInheritanceInfo(&inheritanceInfo);
+        [[maybe_unused]]
+        const auto beginResult = commandBuffer.begin(beginInfo);
+        VK_ASSERT(beginResult, "Failed to begin command buffer");
+    }
     inline void EndCommand(const vk::CommandBuffer commandBuffer)
     {
         [[maybe_unused]]
@@ -115,21 +187,30 @@ namespace Swift::Vulkan::Util
         const Context& context,
         vk::CommandBuffer commandBuffer,
         u32 queueIndex,
-        const dds::Header& ddsImage,
-        std::string_view filePath,
+        const DDS::Header& ddsImage,
+        const MappedFile& file,
         u32 mipLevel,
         bool loadAllMips,
-        const Image& image);
+        const Image& image,
+        StagingRing& stagingRing,
+        u64 ticket,
+        u32 dstBaseMip = 0);
 
+    // dstBaseMip is the image level mipLevel lands in, non zero for images that keep the full
+    // chain allocated while only part of it is uploaded
     void CopyBufferToImage(
+        const Context& context,
         vk::CommandBuffer commandBuffer,
         vk::Buffer buffer,
-        const dds::Header& ddsImage,
+        vk::DeviceSize bufferOffset,
+        const DDS::Header& ddsImage,
         u32 maxMipLevel,
         bool loadAllMips,
-        vk::Image image);
+        vk::Image image,
+        u32 dstBaseMip = 0);
 
     void CopyImage(
+        const Context& context,
         vk::CommandBuffer commandBuffer,
         vk::Image srcImage,
         vk::ImageLayout srcLayout,
@@ -138,6 +219,7 @@ namespace Swift::Vulkan::Util
         vk::Extent2D extent);
 
     void BlitImage(
+        const Context& context,
         vk::CommandBuffer commandBuffer,
         vk::Image srcImage,
         vk::ImageLayout srcLayout,
@@ -160,6 +242,14 @@ namespace Swift::Vulkan::Util
         u32 arrayElement,
         const vk::Device& device);
 
+    // Writes every sampler in a single updateDescriptorSets call
+    void UpdateDescriptorSamplers(
+        vk::DescriptorSet set,
+        std::span<const vk::ImageView> imageViews,
+        std::span<const u32> arrayElements,
+        vk::Sampler sampler,
+        const vk::Device& device);
+
     template <typename T>
     static void NameObject(
         T object,
@@ -215,12 +305,28 @@ namespace Swift::Vulkan::Util
         Image& image,
         vk::ImageAspectFlags flags,
         u32 mipCount = 1,
-        u32 arrayLayers = 1);
+        u32 arrayLayers = 1,
+        u32 srcQueueFamily = vk::QueueFamilyIgnored,
+        u32 dstQueueFamily = vk::QueueFamilyIgnored,
+        u32 baseMip = 0);
 
     void PipelineBarrier(
+        const Context& context,
         vk::CommandBuffer commandBuffer,
         vk::ArrayProxy<vk::ImageMemoryBarrier2> imageBarriers);
 
+    vk::BufferMemoryBarrier2 BufferBarrier(
+        vk::Buffer buffer,
+        vk::DeviceSize offset = 0,
+        vk::DeviceSize size = vk::WholeSize,
+        u32 srcQueueFamily = vk::QueueFamilyIgnored,
+        u32 dstQueueFamily = vk::QueueFamilyIgnored);
+
+    void PipelineBarrier(
+        const Context& context,
+        vk::CommandBuffer commandBuffer,
+        vk::ArrayProxy<vk::BufferMemoryBarrier2> bufferBarriers);
+
     inline vk::Extent2D To2D(const glm::uvec2 extent)
     {
         return vk::Extent2D(extent.x, extent.y);
@@ -231,6 +337,7 @@ namespace Swift::Vulkan::Util
     }
 
     void ClearColorImage(
+        const Context& context,
         const vk::CommandBuffer& commandBuffer,
         const Image& image,
         const vk::ClearColorValue& clearColor);
@@ -242,6 +349,40 @@ namespace Swift::Vulkan::Util
         return (originalSize + alignment - 1) & ~(alignment - 1);
     }
 
+    // FNV-1a, only used to key caches so it does not need to be strong
+    inline u64 HashBytes(
+        const std::span<const char> bytes,
+        u64 seed = 0xcbf29ce484222325)
+    {
+        for (const auto byte : bytes)
+        {
+            seed ^= static_cast<u8>(byte);
+            seed *= 0x100000001b3;
+        }
+        return seed;
+    }
+    template <typename T>
+    u64 HashValue(
+        const T& value,
+        const u64 seed = 0xcbf29ce484222325)
+    {
+        static_assert(std::has_unique_object_representations_v<T>);
+        return HashBytes(std::span(reinterpret_cast<const char*>(&value), sizeof(T)), seed);
+    }
+
+    // Size of the push constant block a SPIR-V module declares, 0 when it has none
+    u32 ReflectPushConstantSize(std::span<const char> code);
+    // Ranges a shader's pipeline layout is created with, stage flags are only the stages that
+    // declare the block
+    vk::PushConstantRange ReflectGraphicsPushConstantRange(
+        std::span<const char> vertexCode,
+        std::span<const char> fragmentCode);
+    vk::PushConstantRange ReflectComputePushConstantRange(std::span<const char> computeCode);
+
+    void SavePipelineCache(
+        const Context& context,
+        std::string_view filePath);
+
     void* MapBuffer(
         const Context& context,
         const Buffer& buffer);
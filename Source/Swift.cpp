@@ -1,4 +1,9 @@
 #include "Swift.hpp"
+#include "Utils/FileIO.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Utils/SlotMap.hpp"
+#include "Utils/ThreadPool.hpp"
+#include "Vulkan/VulkanConstants.hpp"
 #include "Vulkan/VulkanInit.hpp"
 #include "Vulkan/VulkanRender.hpp"
 #include "Vulkan/VulkanStructs.hpp"
@@ -16,29 +21,172 @@ namespace
     Vulkan::Queue gComputeQueue;
     Vulkan::Queue gTransferQueue;
 
-    Vulkan::Command gTransferCommand;
-    vk::Fence gTransferFence;
+    // Transfer batches are recorded round robin, so a new batch can begin while earlier ones
+    // are still executing
+    std::array<
+        Vulkan::Command,
+        Vulkan::Constants::TransferCommandCount>
+        gTransferCommands;
+    std::array<
+        u64,
+        Vulkan::Constants::TransferCommandCount>
+        gTransferCommandTickets{};
+    u32 gTransferCommandIndex = 0;
+    Vulkan::Command gTransferCommand; // Batch currently being recorded
+    // Signalled with the ticket of each transfer batch
+    vk::Semaphore gTransferTimeline;
+    bool gRecordingTransfer = false;
+
+    // Compute batches are recorded round robin like transfer batches and run on the compute queue
+    std::array<
+        Vulkan::Command,
+        Vulkan::Constants::ComputeCommandCount>
+        gComputeCommands;
+    std::array<
+        u64,
+        Vulkan::Constants::ComputeCommandCount>
+        gComputeCommandTickets{};
+    u32 gComputeCommandIndex = 0;
+    // Signalled with the ticket of each compute batch
+    vk::Semaphore gComputeTimeline;
+    u64 gComputeTicket = 0;
+    // Last compute ticket a graphics submit waited on
+    u64 gComputeWaitTicket = 0;
+    // Last transfer ticket a compute batch waited on
+    u64 gComputeTransferWaitTicket = 0;
+    // Graphics timeline value the batch being recorded has to wait for, 0 when there is none
+    u64 gComputeGraphicsWaitValue = 0;
+    // Acquires for buffers released to compute, keyed by the graphics value of the releasing frame
+    std::vector<std::pair<
+        u64,
+        vk::BufferMemoryBarrier2>>
+        gPendingComputeAcquires;
+    // Acquires for buffers the batch being recorded releases to graphics
+    std::vector<vk::BufferMemoryBarrier2> gComputeReleaseBarriers;
+
+    // Each pool worker records into its own command pool and staging ring so batch loads need no
+    // locking while decoding and uploading
+    struct LoadWorker
+    {
+        Vulkan::Command command;
+        Vulkan::StagingRing stagingRing;
+        u64 ticket{}; // Last batch this worker's command buffer was submitted with
+    };
+    std::unique_ptr<ThreadPool> gThreadPool;
+    // Frame work only, so a long load on the thread pool never delays culling
+    std::unique_ptr<JobSystem> gJobSystem;
+    std::vector<LoadWorker> gLoadWorkers;
 
     Vulkan::Command gGraphicsCommand; // For non render loop operations
-    vk::Fence gGraphicsFence;         // For non render loop operations
+    // Signalled with the next value by every graphics queue submission. Frame slots and deferred
+    // deletions record the value of the submission that last used them.
+    vk::Semaphore gGraphicsTimeline;
+    u64 gGraphicsTimelineValue = 0;
 
     Vulkan::Swapchain gSwapchain;
+    // Window extent the swapchain was last checked against
+    glm::uvec2 gWindowExtent{};
     Vulkan::BindlessDescriptor gDescriptor;
     // TODO: sampler pool for all types of samplers
     vk::Sampler gLinearSampler;
 
     std::vector<Vulkan::Thread> gThreadDatas;
-    std::vector<Vulkan::Buffer> gTransferStagingBuffers;
-    std::vector<Vulkan::Buffer> gBuffers;
-    std::vector<Vulkan::Shader> gShaders;
+    Vulkan::StagingRing gTransferStagingRing;
+    // Ticket of the last submitted transfer batch, staging allocations are tagged with the next one
+    u64 gTransferTicket = 0;
+    // Last ticket a graphics submit waited on
+    u64 gTransferWaitTicket = 0;
+    // Uploads too large for the staging ring, tagged with their transfer ticket
+    std::vector<std::pair<
+        u64,
+        Vulkan::Buffer>>
+        gTransferStagingBuffers;
+    // Ownership acquires for images released by the batch being recorded
+    std::vector<vk::ImageMemoryBarrier2> gTransferAcquireBarriers;
+    // Ownership acquires for submitted batches, recorded into the next graphics command buffer
+    std::vector<vk::ImageMemoryBarrier2> gPendingAcquireBarriers;
+    std::vector<vk::BufferMemoryBarrier2> gPendingBufferAcquireBarriers;
+    SlotMap<Vulkan::Buffer> gBuffers;
+    SlotMap<Vulkan::Shader> gShaders;
+    Vulkan::PipelineLayoutCache gPipelineLayoutCache;
+    struct CachedShader
+    {
+        u64 hash{};
+        u32 refCount{};
+        // Kept so a hash hit is only trusted once the SPIR-V matches byte for byte. The fragment
+        // code is empty for compute shaders
+        std::vector<char> vertexCode;
+        std::vector<char> fragmentCode;
+    };
+    // Shaders created again from the same SPIR-V hand out the existing handle. A multimap so two
+    // different shaders whose hashes collide are both cached
+    std::unordered_multimap<
+        u64,
+        ShaderHandle>
+        gShaderCache;
+    std::unordered_map<
+        ShaderHandle,
+        CachedShader>
+        gCachedShaders;
+    struct PendingShader
+    {
+        // Shared so a thread can wait on it without holding gShaderMutex
+        std::shared_future<Vulkan::Shader> future;
+        bool bCompute{};
+        // Reflected up front so BindShader can tell whether the fallback shares the interface
+        vk::PushConstantRange pushConstantRange;
+    };
+    // Shaders still compiling on the thread pool, their slots hold an empty shader until then
+    std::unordered_map<
+        ShaderHandle,
+        PendingShader>
+        gPendingShaders;
+    // Guards gPendingShaders and the slots they resolve into, as RecordParallel jobs bind shaders
+    // from several threads
+    std::mutex gShaderMutex;
+    ShaderHandle gFallbackGraphicsShader = InvalidHandle;
+    ShaderHandle gFallbackComputeShader = InvalidHandle;
     u32 gCurrentShader = 0;
-    std::vector<Vulkan::Image> gWriteableImages;
-    std::vector<Vulkan::Image> gSamplerImages;
-    std::vector<Vulkan::Image> gTemporaryImages;
+
+    // Swift:: recording calls made from a RecordParallel job or between BeginCompute and
+    // EndCompute go to that command buffer instead of the frame's
+    struct CommandRecording
+    {
+        vk::CommandBuffer commandBuffer;
+        Vulkan::StateTracker state;
+        u32 currentShader = InvalidHandle;
+    };
+    thread_local CommandRecording* tRecording = nullptr;
+    CommandRecording gComputeRecording;
+    bool gParallelRendering = false;
+    // Queried once at Init, see SupportsSubgroupBallot
+    bool gSubgroupBallot = false;
+    // Image handles keep the usage type in their low bits, which leaves 14 bits for the
+    // generation, so a stale handle only validates again after 16383 reuses of its slot. The slot
+    // index doubles as the bindless array element for both the sampler and storage bindings.
+    constexpr u32 ImageUsageBits = 2;
+    using ImagePool = SlotMap<Vulkan::Image, 32 - ImageUsageBits - 16>;
+    ImagePool gImages;
+    ImagePool gTemporaryImages;
+    // Guards both image pools against concurrent loads and destroys
+    std::mutex gImageMutex;
+    // Min LODs requested by SetImageMinLod, applied at the start of the next frame. The clamp is
+    // part of the view, so each change needs a new view and descriptor write, and batching them
+    // keeps a burst of streaming completions to one descriptor update. Guarded by gImageMutex.
+    std::unordered_map<
+        ImageHandle,
+        int>
+        gPendingMinLods;
 
     std::vector<Vulkan::FrameData> gFrameData;
     u32 gCurrentFrame = 0;
+    u32 gMaxFrameLatency = 0;
+    // Indexed by swapchain image rather than frame slot. The present waiting on one is only known
+    // to be done once its image is acquired again, which a frame slot fence does not cover.
+    std::vector<vk::Semaphore> gPresentSemaphores;
     Vulkan::FrameData gCurrentFrameData;
+    bool gRecordingFrame = false;
+    Vulkan::DeletionQueue gDeletionQueue;
 
     InitInfo gInitInfo;
 
@@ -46,33 +194,357 @@ namespace
         const u32 value,
         const ImageUsage type)
     {
-        return (value << 8) | (static_cast<u32>(type) & 0xFF);
+        return (value << ImageUsageBits) | static_cast<u32>(type);
     }
 
     ImageUsage GetImageType(const u32 value)
     {
-        return static_cast<ImageUsage>(value & 0xFF);
+        return static_cast<ImageUsage>(value & ((1u << ImageUsageBits) - 1));
+    }
+
+    u32 GetImageSlot(const u32 value)
+    {
+        return value >> ImageUsageBits;
     }
 
     u32 GetImageIndex(const u32 value)
     {
-        return (value >> 8) & 0xFFFFFF;
+        return ImagePool::GetIndex(GetImageSlot(value));
+    }
+
+    ImagePool& GetImagePool(const u32 imageHandle)
+    {
+        if (GetImageType(imageHandle) == ImageUsage::eTemporary)
+        {
+            return gTemporaryImages;
+        }
+        return gImages;
     }
 
     Vulkan::Image& GetRealImage(const u32 imageHandle)
     {
-        const auto index = GetImageIndex(imageHandle);
-        switch (GetImageType(imageHandle))
+        return GetImagePool(imageHandle).Get(GetImageSlot(imageHandle));
+    }
+
+    // Frees staging memory of every transfer batch the GPU has finished
+    void RetireTransfers()
+    {
+        const auto completed = Vulkan::Util::GetSemaphoreValue(gContext, gTransferTimeline);
+        gTransferStagingRing.Reclaim(completed);
+        for (auto& worker : gLoadWorkers)
+        {
+            worker.stagingRing.Reclaim(completed);
+        }
+        std::erase_if(
+            gTransferStagingBuffers,
+            [completed](const std::pair<u64, Vulkan::Buffer>& staging)
+            {
+                if (staging.first > completed)
+                {
+                    return false;
+                }
+                staging.second.Destroy(gContext);
+                return true;
+            });
+    }
+
+    void RecordPendingAcquires(const vk::CommandBuffer commandBuffer)
+    {
+        if (!gPendingAcquireBarriers.empty())
+        {
+            Vulkan::Util::PipelineBarrier(gContext, commandBuffer, gPendingAcquireBarriers);
+            gPendingAcquireBarriers.clear();
+        }
+        if (!gPendingBufferAcquireBarriers.empty())
+        {
+            Vulkan::Util::PipelineBarrier(gContext, commandBuffer, gPendingBufferAcquireBarriers);
+            gPendingBufferAcquireBarriers.clear();
+        }
+    }
+
+    // Ownership only moves between distinct families, within one family the barrier is a plain
+    // memory dependency
+    vk::BufferMemoryBarrier2 OwnershipBarrier(
+        const vk::Buffer buffer,
+        const u32 srcFamily,
+        const u32 dstFamily)
+    {
+        if (srcFamily == dstFamily)
+        {
+            return Vulkan::Util::BufferBarrier(buffer);
+        }
+        return Vulkan::Util::BufferBarrier(buffer, 0, vk::WholeSize, srcFamily, dstFamily);
+    }
+
+    // Shared by batched image loads and async shader compilation, created on first use
+    ThreadPool& GetThreadPool()
+    {
+        if (!gThreadPool)
+        {
+            // Leave a core for the thread submitting the work
+            const auto threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+            gThreadPool = std::make_unique<ThreadPool>(threadCount);
+        }
+        return *gThreadPool;
+    }
+
+    void CreateLoadWorkers()
+    {
+        const auto threadCount = GetThreadPool().GetThreadCount();
+        // The workers share the configured staging budget
+        const auto ringSize =
+            std::max<u64>(gInitInfo.stagingBufferSize / threadCount, 8 * 1024 * 1024);
+        gLoadWorkers.resize(threadCount);
+        for (auto& [command, stagingRing, ticket] : gLoadWorkers)
+        {
+            command.commandPool = Vulkan::Init::CreateCommandPool(
+                gContext,
+                gTransferQueue.index,
+                "Load Worker Command Pool");
+            command.commandBuffer = Vulkan::Init::CreateCommandBuffer(
+                gContext,
+                command.commandPool,
+                "Load Worker Command Buffer");
+            stagingRing = Vulkan::Init::CreateStagingRing(
+                gContext,
+                gTransferQueue.index,
+                ringSize,
+                "Load Worker Staging Ring");
+        }
+    }
+
+    std::optional<ShaderHandle> AcquireCachedShader(
+        const u64 hash,
+        const std::span<const char> vertexCode,
+        const std::span<const char> fragmentCode = {})
+    {
+        const auto [begin, end] = gShaderCache.equal_range(hash);
+        for (auto it = begin; it != end; ++it)
+        {
+            auto& cachedShader = gCachedShaders.at(it->second);
+            if (std::ranges::equal(cachedShader.vertexCode, vertexCode) &&
+                std::ranges::equal(cachedShader.fragmentCode, fragmentCode))
+            {
+                cachedShader.refCount++;
+                return it->second;
+            }
+        }
+        return std::nullopt;
+    }
+
+    ShaderHandle InsertCachedShader(
+        const u64 hash,
+        const Vulkan::Shader& shader,
+        const std::span<const char> vertexCode,
+        const std::span<const char> fragmentCode = {})
+    {
+        const auto shaderHandle = gShaders.Insert(shader);
+        gShaderCache.emplace(hash, shaderHandle);
+        gCachedShaders.emplace(
+            shaderHandle,
+            CachedShader(
+                hash,
+                1,
+                std::vector(vertexCode.begin(), vertexCode.end()),
+                std::vector(fragmentCode.begin(), fragmentCode.end())));
+        return shaderHandle;
+    }
+
+    // Seeded with the stage count so a compute shader can never alias a graphics one
+    u64 HashGraphicsShader(
+        const std::span<const char> vertexCode,
+        const std::span<const char> fragmentCode)
+    {
+        const auto hash = Vulkan::Util::HashBytes(vertexCode, Vulkan::Util::HashValue(2u));
+        return Vulkan::Util::HashBytes(fragmentCode, hash);
+    }
+
+    u64 HashComputeShader(const std::span<const char> computeCode)
+    {
+        return Vulkan::Util::HashBytes(computeCode, Vulkan::Util::HashValue(1u));
+    }
+
+    // Moves a finished compilation into its slot. Returns false while it is still compiling.
+    bool ResolvePendingShader(
+        const ShaderHandle shaderHandle,
+        const bool bWait)
+    {
+        std::shared_future<Vulkan::Shader> future;
+        {
+            std::scoped_lock lock(gShaderMutex);
+            const auto it = gPendingShaders.find(shaderHandle);
+            if (it == gPendingShaders.end())
+            {
+                return true;
+            }
+            future = it->second.future;
+        }
+        if (!bWait && future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+        future.wait();
+
+        // Another thread may have moved it into its slot while this one waited
+        std::scoped_lock lock(gShaderMutex);
+        if (const auto it = gPendingShaders.find(shaderHandle); it != gPendingShaders.end())
+        {
+            gShaders.Get(shaderHandle) = future.get();
+            gPendingShaders.erase(it);
+        }
+        return true;
+    }
+
+    // The fallback BindShader may stand in with while shaderHandle compiles, InvalidHandle when
+    // there is none with the same push constant block or the shader was resolved meanwhile
+    ShaderHandle GetFallbackShader(const ShaderHandle shaderHandle)
+    {
+        std::scoped_lock lock(gShaderMutex);
+        const auto it = gPendingShaders.find(shaderHandle);
+        if (it == gPendingShaders.end())
+        {
+            return InvalidHandle;
+        }
+        const auto& pendingShader = it->second;
+        const auto fallback =
+            pendingShader.bCompute ? gFallbackComputeShader : gFallbackGraphicsShader;
+        // The push constants and draws that follow were written for the pending shader, so a
+        // fallback with a different push constant block would read them as something else
+        if (!IsValid(fallback) ||
+            gShaders.Get(fallback).pushConstantRange != pendingShader.pushConstantRange)
+        {
+            return InvalidHandle;
+        }
+        return fallback;
+    }
+
+    void ResolveAllPendingShaders()
+    {
+        for (auto& [handle, pendingShader] : gPendingShaders)
+        {
+            gShaders.Get(handle) = pendingShader.future.get();
+        }
+        gPendingShaders.clear();
+    }
+
+    // The frame slot's previous submission has retired by the time BeginFrame records into it
+    void ResetWorkerCommands(Vulkan::FrameData& frameData)
+    {
+        for (auto& worker : frameData.workerCommands)
+        {
+            if (worker.usedCount == 0)
+            {
+                continue;
+            }
+            [[maybe_unused]]
+            const auto result = gContext.device.resetCommandPool(worker.commandPool);
+            VK_ASSERT(result, "Failed to reset worker command pool");
+            worker.usedCount = 0;
+        }
+    }
+
+    vk::CommandBuffer GetRecordingCommandBuffer()
+    {
+        if (tRecording)
+        {
+            return tRecording->commandBuffer;
+        }
+        return Vulkan::Render::GetCommandBuffer(gCurrentFrameData);
+    }
+
+    Vulkan::StateTracker& GetRecordingState()
+    {
+        if (tRecording)
+        {
+            return tRecording->state;
+        }
+        return Vulkan::Render::GetRenderState(gCurrentFrameData);
+    }
+
+    vk::Semaphore GetPresentSemaphore(const u32 imageIndex)
+    {
+        // A recreated swapchain may come back with more images
+        while (gPresentSemaphores.size() <= imageIndex)
+        {
+            gPresentSemaphores.emplace_back(
+                Vulkan::Init::CreateSemaphore(gContext, "Present Semaphore"));
+        }
+        return gPresentSemaphores[imageIndex];
+    }
+
+    // Value the next graphics submission signals, anything in use now retires with it
+    u64 GetPendingGraphicsValue()
+    {
+        return gGraphicsTimelineValue + 1;
+    }
+
+    // Runs in BeginFrame, before the frame records anything that samples the images
+    void ApplyPendingMinLods()
+    {
+        std::scoped_lock lock(gImageMutex);
+        if (gPendingMinLods.empty())
+        {
+            return;
+        }
+        std::vector<vk::ImageView> oldViews;
+        std::vector<vk::ImageView> imageViews;
+        std::vector<u32> arrayElements;
+        oldViews.reserve(gPendingMinLods.size());
+        imageViews.reserve(gPendingMinLods.size());
+        arrayElements.reserve(gPendingMinLods.size());
+        for (const auto& [imageHandle, minLod] : gPendingMinLods)
         {
-        case ImageUsage::eSampledReadWrite:
-        case ImageUsage::eReadWrite:
-            return gWriteableImages[index];
-        case ImageUsage::eSampled:
-            return gSamplerImages[index];
-        case ImageUsage::eTemporary:
-            return gTemporaryImages[index];
+            auto& realImage = GetRealImage(imageHandle);
+            oldViews.emplace_back(realImage.imageView);
+            realImage.imageView =
+                Vulkan::Init::CreateMinLodImageView(gContext, realImage, minLod, realImage.uri);
+            realImage.minLod = minLod;
+            imageViews.emplace_back(realImage.imageView);
+            arrayElements.emplace_back(GetImageIndex(imageHandle));
         }
-        return gSamplerImages[index];
+        gPendingMinLods.clear();
+
+        // Frames in flight may still sample through the old views
+        gDeletionQueue.Push(
+            GetPendingGraphicsValue(),
+            [oldViews = std::move(oldViews)]
+            {
+                for (const auto oldView : oldViews)
+                {
+                    gContext.device.destroyImageView(oldView);
+                }
+            });
+        Vulkan::Util::UpdateDescriptorSamplers(
+            gDescriptor.set,
+            imageViews,
+            arrayElements,
+            gLinearSampler,
+            gContext);
+    }
+
+    // Frames in flight may still render to the old images or wait to present them, so they are
+    // retired through the deletion queue instead of idling the device. Their presents were queued
+    // ahead of the next graphics submission, so it retires them like any other deletion.
+    void RecreateSwapchain(const vk::Extent2D extent)
+    {
+        const auto oldSwapchain =
+            Vulkan::Util::RecreateSwapchain(gGraphicsQueue.index, gContext, gSwapchain, extent);
+        gDeletionQueue.Push(
+            GetPendingGraphicsValue(),
+            [oldSwapchain, presentSemaphores = std::move(gPresentSemaphores)]() mutable
+            {
+                oldSwapchain.Destroy(gContext);
+                for (const auto presentSemaphore : presentSemaphores)
+                {
+                    gContext.device.destroy(presentSemaphore);
+                }
+            });
+        gPresentSemaphores.clear();
+    }
+
+    u32& GetCurrentShader()
+    {
+        return tRecording ? tRecording->currentShader : gCurrentShader;
     }
 } // namespace
 
@@ -81,6 +553,7 @@ using namespace Vulkan;
 void Swift::Init(const InitInfo& initInfo)
 {
     gInitInfo = initInfo;
+    gWindowExtent = initInfo.extent;
 
     gContext = Init::CreateContext(initInfo);
 
@@ -92,36 +565,62 @@ void Swift::Init(const InitInfo& initInfo)
     const auto transferQueue = Init::GetQueue(gContext, indices[2], 0, "Transfer Queue");
     gTransferQueue.SetIndex(indices[2]).SetQueue(transferQueue);
 
+    vk::StructureChain<
+        vk::PhysicalDeviceProperties2,
+        vk::PhysicalDeviceSubgroupProperties>
+        propertiesChain;
+    gContext.gpu.getProperties2(&propertiesChain.get<vk::PhysicalDeviceProperties2>());
+    const auto& subgroupProperties = propertiesChain.get<vk::PhysicalDeviceSubgroupProperties>();
+    gSubgroupBallot =
+        (subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eBallot) &&
+        (subgroupProperties.supportedStages & vk::ShaderStageFlagBits::eCompute);
+
+    // The surface has the final say on the swapchain extent, the depth image has to match it
+    const auto extent = initInfo.bHeadless ? Util::To2D(initInfo.extent)
+                                           : Util::GetSwapchainExtent(
+                                                 gContext.gpu,
+                                                 gContext.surface,
+                                                 Util::To2D(initInfo.extent));
     constexpr auto depthFormat = vk::Format::eD32Sfloat;
     const auto depthImage = Init::CreateImage(
         gContext,
         vk::ImageType::e2D,
-        Util::To3D(initInfo.extent),
+        vk::Extent3D(extent, 1),
         depthFormat,
-        vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        vk::ImageUsageFlagBits::eDepthStencilAttachment |
+            vk::ImageUsageFlagBits::eTransferSrc,
         1,
         {},
         "Swapchain Depth");
 
-    const auto swapchain =
-        Init::CreateSwapchain(gContext, Util::To2D(initInfo.extent), gGraphicsQueue.index);
-    gSwapchain.SetSwapchain(swapchain)
-        .SetDepthImage(depthImage)
-        .SetImages(Init::CreateSwapchainImages(gContext, gSwapchain))
-        .SetExtent(Util::To2D(initInfo.extent));
+    const auto framesInFlight = std::max(initInfo.framesInFlight, 1u);
+    if (initInfo.bHeadless)
+    {
+        // One offscreen image per frame slot, so the slot's fence also guards its image
+        gSwapchain.SetDepthImage(depthImage)
+            .SetImages(Init::CreateHeadlessImages(gContext, extent, framesInFlight))
+            .SetExtent(extent);
+    }
+    else
+    {
+        const auto swapchain = Init::CreateSwapchain(gContext, extent, gGraphicsQueue.index);
+        gSwapchain.SetSwapchain(swapchain)
+            .SetDepthImage(depthImage)
+            .SetImages(Init::CreateSwapchainImages(gContext, gSwapchain))
+            .SetExtent(extent);
+    }
 
-    gFrameData.resize(gSwapchain.images.size());
-    for (auto& [renderSemaphore, presentSemaphore, renderFence, renderCommand] : gFrameData)
+    gFrameData.resize(framesInFlight);
+    for (auto& frameData : gFrameData)
     {
-        renderFence =
-            Init::CreateFence(gContext, vk::FenceCreateFlagBits::eSignaled, "Render Fence");
-        renderSemaphore = Init::CreateSemaphore(gContext, "Render Semaphore");
-        presentSemaphore = Init::CreateSemaphore(gContext, "Present Semaphore");
+        frameData.renderSemaphore = Init::CreateSemaphore(gContext, "Render Semaphore");
+        auto& renderCommand = frameData.renderCommand;
         renderCommand.commandPool =
             Init::CreateCommandPool(gContext, gGraphicsQueue.index, "Command Pool");
         renderCommand.commandBuffer =
             Init::CreateCommandBuffer(gContext, renderCommand.commandPool, "Command Buffer");
     }
+    SetMaxFrameLatency(initInfo.maxFrameLatency);
 
     gDescriptor.SetDescriptorSetLayout(Init::CreateDescriptorSetLayout(gContext))
         .SetDescriptorPool(Init::CreateDescriptorPool(gContext, {}))
@@ -130,13 +629,32 @@ void Swift::Init(const InitInfo& initInfo)
 
     gLinearSampler = Init::CreateSampler(gContext);
 
-    gTransferCommand.commandPool =
-        Init::CreateCommandPool(gContext, gTransferQueue.index, "Transfer Command Pool");
-    gTransferCommand.commandBuffer = Init::CreateCommandBuffer(
+    for (auto& transferCommand : gTransferCommands)
+    {
+        transferCommand.commandPool =
+            Init::CreateCommandPool(gContext, gTransferQueue.index, "Transfer Command Pool");
+        transferCommand.commandBuffer = Init::CreateCommandBuffer(
+            gContext,
+            transferCommand.commandPool,
+            "Transfer Command Buffer");
+    }
+    gTransferTimeline = Init::CreateTimelineSemaphore(gContext, 0, "Transfer Timeline");
+
+    for (auto& computeCommand : gComputeCommands)
+    {
+        computeCommand.commandPool =
+            Init::CreateCommandPool(gContext, gComputeQueue.index, "Compute Command Pool");
+        computeCommand.commandBuffer = Init::CreateCommandBuffer(
+            gContext,
+            computeCommand.commandPool,
+            "Compute Command Buffer");
+    }
+    gComputeTimeline = Init::CreateTimelineSemaphore(gContext, 0, "Compute Timeline");
+    gTransferStagingRing = Init::CreateStagingRing(
         gContext,
-        gTransferCommand.commandPool,
-        "Transfer Command Buffer");
-    gTransferFence = Init::CreateFence(gContext, {}, "Transfer Fence");
+        gTransferQueue.index,
+        initInfo.stagingBufferSize,
+        "Transfer Staging Ring");
 
     gGraphicsCommand.commandPool =
         Init::CreateCommandPool(gContext, gGraphicsQueue.index, "Graphics Command Pool");
@@ -144,7 +662,7 @@ void Swift::Init(const InitInfo& initInfo)
         gContext,
         gGraphicsCommand.commandPool,
         "Graphics Command Buffer");
-    gGraphicsFence = Init::CreateFence(gContext, {}, "Graphics Fence");
+    gGraphicsTimeline = Init::CreateTimelineSemaphore(gContext, 0, "Graphics Timeline");
 }
 
 void Swift::Shutdown()
@@ -152,42 +670,77 @@ void Swift::Shutdown()
     [[maybe_unused]]
     const auto result = gContext.device.waitIdle();
     VK_ASSERT(result, "Failed to wait for device while cleaning up");
+    ResolveAllPendingShaders();
+    if (!gInitInfo.pipelineCachePath.empty())
+    {
+        Util::SavePipelineCache(gContext, gInitInfo.pipelineCachePath);
+    }
+    gDeletionQueue.FlushAll();
+    gThreadPool.reset();
+    gJobSystem.reset();
+    for (auto& [command, stagingRing, ticket] : gLoadWorkers)
+    {
+        command.Destroy(gContext);
+        stagingRing.Destroy(gContext);
+    }
+    gLoadWorkers.clear();
 
     for (auto& frameData : gFrameData)
     {
         frameData.Destroy(gContext);
     }
-    gDescriptor.Destroy(gContext);
-
-    for (const auto& shader : gShaders)
+    for (const auto presentSemaphore : gPresentSemaphores)
     {
-        shader.Destroy(gContext);
+        gContext.device.destroy(presentSemaphore);
     }
+    gPresentSemaphores.clear();
+    gDescriptor.Destroy(gContext);
 
-    for (auto& image : gWriteableImages)
-    {
-        image.Destroy(gContext);
-    }
+    gShaders.ForEach(
+        [](const Shader& shader)
+        {
+            shader.Destroy(gContext);
+        });
+    gShaderCache.clear();
+    gCachedShaders.clear();
+    gPipelineLayoutCache.Destroy(gContext);
+    gPipelineLayoutCache.layouts.clear();
+
+    gImages.ForEach(
+        [](Image& image)
+        {
+            image.Destroy(gContext);
+        });
 
-    for (auto& image : gSamplerImages)
+    gTemporaryImages.ForEach(
+        [](Image& image)
+        {
+            image.Destroy(gContext);
+        });
+
+    gBuffers.ForEach(
+        [](const Buffer& buffer)
+        {
+            buffer.Destroy(gContext);
+        });
+
+    for (auto& transferCommand : gTransferCommands)
     {
-        image.Destroy(gContext);
+        transferCommand.Destroy(gContext);
     }
-
-    for (auto& image : gTemporaryImages)
+    for (auto& computeCommand : gComputeCommands)
     {
-        image.Destroy(gContext);
+        computeCommand.Destroy(gContext);
     }
-
-    for (auto& buffer : gBuffers)
+    gContext.device.destroy(gComputeTimeline);
+    for (const auto& [ticket, buffer] : gTransferStagingBuffers)
     {
         buffer.Destroy(gContext);
     }
-
-    gTransferCommand.Destroy(gContext);
     gGraphicsCommand.Destroy(gContext);
-    gContext.device.destroy(gTransferFence);
-    gContext.device.destroy(gGraphicsFence);
+    gContext.device.destroy(gTransferTimeline);
+    gTransferStagingRing.Destroy(gContext);
+    gContext.device.destroy(gGraphicsTimeline);
     gContext.device.destroy(gLinearSampler);
 
     gSwapchain.Destroy(gContext);
@@ -236,85 +789,376 @@ bool Swift::SupportsGraphicsMultithreading()
     return queueFamilyProps.at(gGraphicsQueue.index).queueCount > 1;
 }
 
-void Swift::BeginFrame(const DynamicInfo& dynamicInfo)
+bool Swift::SupportsSubgroupBallot()
+{
+    return gSubgroupBallot;
+}
+
+u32 Swift::GetFrameIndex()
+{
+    return gCurrentFrame;
+}
+
+u32 Swift::GetFramesInFlight()
+{
+    return static_cast<u32>(gFrameData.size());
+}
+
+JobSystem& Swift::GetJobSystem()
+{
+    if (!gJobSystem)
+    {
+        // The thread waiting on the jobs runs them too
+        const auto threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        gJobSystem = std::make_unique<JobSystem>(threadCount);
+    }
+    return *gJobSystem;
+}
+
+glm::uvec2 Swift::GetSwapchainExtent()
+{
+    return {gSwapchain.extent.width, gSwapchain.extent.height};
+}
+
+u32 Swift::GetSwapchainImageCount()
+{
+    return static_cast<u32>(gSwapchain.images.size());
+}
+
+void Swift::SetMaxFrameLatency(const u32 maxFrameLatency)
+{
+    const auto framesInFlight = GetFramesInFlight();
+    gMaxFrameLatency = maxFrameLatency == 0 ? framesInFlight
+                                            : std::min(maxFrameLatency, framesInFlight);
+}
+
+u32 Swift::GetMaxFrameLatency()
+{
+    return gMaxFrameLatency;
+}
+
+bool Swift::BeginFrame(const DynamicInfo& dynamicInfo)
 {
     gCurrentFrameData = gFrameData[gCurrentFrame];
     const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    const auto& renderFence = Render::GetRenderFence(gCurrentFrameData);
 
-    Util::WaitFence(gContext, renderFence, 1000000000);
-    gSwapchain.imageIndex = Render::AcquireNextImage(
-        gGraphicsQueue,
+    // Frames retire in submission order, so waiting on a newer frame than the one that last used
+    // this slot bounds how far the CPU runs ahead without shrinking the number of slots. Slots
+    // that were never submitted hold 0, which is always reached.
+    const auto frameCount = static_cast<u32>(gFrameData.size());
+    const auto latencyFrame = (gCurrentFrame + frameCount - gMaxFrameLatency) % frameCount;
+    Util::WaitSemaphore(
         gContext,
-        gSwapchain,
-        gCurrentFrameData.renderSemaphore,
-        Util::To2D(dynamicInfo.extent));
-    Util::ResetFence(gContext, renderFence);
+        gGraphicsTimeline,
+        Render::GetTimelineValue(gFrameData[latencyFrame]));
+    gDeletionQueue.Flush(Util::GetSemaphoreValue(gContext, gGraphicsTimeline));
+    if (gInitInfo.bHeadless)
+    {
+        // There is one offscreen image per frame, so the wait above already guards it
+        gSwapchain.imageIndex = gCurrentFrame;
+    }
+    else
+    {
+        // Compared against what the surface allows rather than the window, so a surface that
+        // insists on another size does not cause a recreate every frame
+        const auto getExtent = [&]
+        {
+            return Util::GetSwapchainExtent(
+                gContext.gpu,
+                gContext.surface,
+                Util::To2D(dynamicInfo.extent));
+        };
+        const auto isEmpty = [](const vk::Extent2D extent)
+        {
+            return extent.width == 0 || extent.height == 0;
+        };
+        // Minimized windows have nothing to present to, so their frames are skipped
+        if (dynamicInfo.extent.x == 0 || dynamicInfo.extent.y == 0)
+        {
+            return false;
+        }
+        // The surface is only asked again once the window was resized or the swapchain reported
+        // itself out of date or suboptimal, which sets bRecreate
+        if (gSwapchain.bRecreate || dynamicInfo.extent != gWindowExtent)
+        {
+            const auto extent = getExtent();
+            if (isEmpty(extent))
+            {
+                return false;
+            }
+            if (gSwapchain.bRecreate || gSwapchain.extent != extent)
+            {
+                RecreateSwapchain(extent);
+            }
+            gWindowExtent = dynamicInfo.extent;
+        }
+        gSwapchain.imageIndex =
+            Render::AcquireNextImage(gContext, gSwapchain, gCurrentFrameData.renderSemaphore);
+        // An out of date swapchain hands out no image at all. Recreating it usually fixes that at
+        // once, otherwise the frame is skipped and bRecreate has the next one try again.
+        constexpr u32 MaxAcquireRetries = 2;
+        for (u32 attempt = 0; attempt < MaxAcquireRetries; attempt++)
+        {
+            if (gSwapchain.imageIndex != std::numeric_limits<u32>::max())
+            {
+                break;
+            }
+            const auto extent = getExtent();
+            if (isEmpty(extent))
+            {
+                return false;
+            }
+            RecreateSwapchain(extent);
+            gSwapchain.imageIndex =
+                Render::AcquireNextImage(gContext, gSwapchain, gCurrentFrameData.renderSemaphore);
+        }
+        if (gSwapchain.imageIndex == std::numeric_limits<u32>::max())
+        {
+            return false;
+        }
+    }
     Util::BeginOneTimeCommand(commandBuffer);
+    Render::GetRenderState(gCurrentFrameData).Reset();
+    ResetWorkerCommands(gFrameData[gCurrentFrame]);
+    ApplyPendingMinLods();
+    RecordPendingAcquires(commandBuffer);
+    RetireTransfers();
+    gRecordingFrame = true;
+    return true;
 }
 
 void Swift::EndFrame(const DynamicInfo& dynamicInfo)
 {
     const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
     const auto& renderSemaphore = Render::GetRenderSemaphore(gCurrentFrameData);
-    const auto& presentSemaphore = Render::GetPresentSemaphore(gCurrentFrameData);
-    const auto& renderFence = Render::GetRenderFence(gCurrentFrameData);
+    const auto presentSemaphore = GetPresentSemaphore(gSwapchain.imageIndex);
     auto& swapchainImage = Render::GetSwapchainImage(gSwapchain);
 
+    // Headless frames are left ready to be copied out instead of presented
+    const auto finalLayout = gInitInfo.bHeadless ? vk::ImageLayout::eTransferSrcOptimal
+                                                 : vk::ImageLayout::ePresentSrcKHR;
     const auto presentBarrier = Util::ImageBarrier(
         swapchainImage.currentLayout,
-        vk::ImageLayout::ePresentSrcKHR,
+        finalLayout,
         swapchainImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, presentBarrier);
+    Util::PipelineBarrier(gContext, commandBuffer, presentBarrier);
 
     Util::EndCommand(commandBuffer);
-    Util::SubmitQueue(
-        gGraphicsQueue,
+    gRecordingFrame = false;
+
+    std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+    const auto frameValue = ++gGraphicsTimelineValue;
+    std::vector<vk::SemaphoreSubmitInfo> signalInfos{
+        vk::SemaphoreSubmitInfo()
+            .setSemaphore(gGraphicsTimeline)
+            .setValue(frameValue)
+            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands)};
+    // Uploads submitted since the last frame have to land before this frame reads them
+    if (gTransferTicket > gTransferWaitTicket)
+    {
+        waitInfos.emplace_back(vk::SemaphoreSubmitInfo()
+                                   .setSemaphore(gTransferTimeline)
+                                   .setValue(gTransferTicket)
+                                   .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+        gTransferWaitTicket = gTransferTicket;
+    }
+    // Likewise for compute batches, which may have produced what this frame draws
+    if (gComputeTicket > gComputeWaitTicket)
+    {
+        waitInfos.emplace_back(vk::SemaphoreSubmitInfo()
+                                   .setSemaphore(gComputeTimeline)
+                                   .setValue(gComputeTicket)
+                                   .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+        gComputeWaitTicket = gComputeTicket;
+    }
+    if (!gInitInfo.bHeadless)
+    {
+        waitInfos.emplace_back(
+            vk::SemaphoreSubmitInfo()
+                .setSemaphore(renderSemaphore)
+                .setStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput));
+        signalInfos.emplace_back(vk::SemaphoreSubmitInfo()
+                                     .setSemaphore(presentSemaphore)
+                                     .setStageMask(vk::PipelineStageFlagBits2::eAllGraphics));
+    }
+    Util::SubmitQueue(gGraphicsQueue, commandBuffer, waitInfos, signalInfos, nullptr);
+    Render::GetTimelineValue(gFrameData[gCurrentFrame]) = frameValue;
+
+    if (!gInitInfo.bHeadless)
+    {
+        Render::Present(gSwapchain, gGraphicsQueue, presentSemaphore);
+    }
+
+    gCurrentFrame = (gCurrentFrame + 1) % gFrameData.size();
+}
+
+void Swift::BeginRendering()
+{
+    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    Render::BeginRendering(gContext, commandBuffer, gSwapchain, true);
+    Render::SetPipelineDefault(
+        gContext,
         commandBuffer,
-        renderSemaphore,
-        vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-        presentSemaphore,
-        vk::PipelineStageFlagBits2::eAllGraphics,
-        renderFence);
-    Render::Present(
+        Render::GetRenderState(gCurrentFrameData),
+        gSwapchain.extent,
+        gInitInfo.bUsePipelines);
+}
+
+void Swift::ResumeRendering()
+{
+    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    Render::BeginRendering(
         gContext,
+        commandBuffer,
         gSwapchain,
-        gGraphicsQueue,
-        presentSemaphore,
-        Util::To2D(dynamicInfo.extent));
+        true,
+        {},
+        vk::AttachmentLoadOp::eLoad);
+    Render::SetPipelineDefault(
+        gContext,
+        commandBuffer,
+        Render::GetRenderState(gCurrentFrameData),
+        gSwapchain.extent,
+        gInitInfo.bUsePipelines);
+}
 
-    gCurrentFrame = (gCurrentFrame + 1) % gSwapchain.images.size();
+void Swift::EndRendering()
+{
+    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    Render::EndRendering(gContext, commandBuffer);
+    if (gParallelRendering)
+    {
+        // Executing secondaries leaves the primary's state undefined
+        Render::GetRenderState(gCurrentFrameData).Reset();
+        gParallelRendering = false;
+    }
 }
 
-void Swift::BeginRendering()
+void Swift::BeginParallelRendering()
 {
     const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    Render::BeginRendering(commandBuffer, gSwapchain, true);
-    Render::SetPipelineDefault(gContext, commandBuffer, gSwapchain.extent, gInitInfo.bUsePipelines);
+    Render::BeginRendering(
+        gContext,
+        commandBuffer,
+        gSwapchain,
+        true,
+        vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+    gParallelRendering = true;
 }
 
-void Swift::EndRendering()
+void Swift::RecordParallel(
+    const u32 jobCount,
+    const std::function<void(u32 jobIndex)>& record)
 {
+    assert(gParallelRendering && "RecordParallel called outside BeginParallelRendering");
+    if (jobCount == 0)
+    {
+        return;
+    }
+
+    // The calling thread records too, as worker 0
+    auto& threadPool = GetThreadPool();
+    const auto workerCount = std::min(threadPool.GetThreadCount() + 1, jobCount);
+    auto& workerCommands = gFrameData[gCurrentFrame].workerCommands;
+    while (workerCommands.size() < workerCount)
+    {
+        workerCommands.emplace_back(
+            Init::CreateCommandPool(gContext, gGraphicsQueue.index, "Worker Command Pool"));
+    }
+
+    const auto colorFormat = Render::GetSwapchainImage(gSwapchain).format;
+    const auto renderingInfo = vk::CommandBufferInheritanceRenderingInfo()
+                                   .setColorAttachmentFormats(colorFormat)
+                                   .setDepthAttachmentFormat(gSwapchain.depthImage.format)
+                                   .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+    std::vector<vk::CommandBuffer> commandBuffers(jobCount);
+    std::atomic<u32> nextJob = 0;
+    const auto recordJobs = [&](WorkerCommands& worker)
+    {
+        for (auto job = nextJob++; job < jobCount; job = nextJob++)
+        {
+            if (worker.usedCount == worker.commandBuffers.size())
+            {
+                worker.commandBuffers.emplace_back(Init::CreateCommandBuffer(
+                    gContext,
+                    worker.commandPool,
+                    "Secondary Command Buffer",
+                    vk::CommandBufferLevel::eSecondary));
+            }
+            CommandRecording recording;
+            recording.commandBuffer = worker.commandBuffers[worker.usedCount++];
+            Util::BeginSecondaryCommand(recording.commandBuffer, renderingInfo);
+            // Dynamic state is not inherited from the primary
+            Render::SetPipelineDefault(
+                gContext,
+                recording.commandBuffer,
+                recording.state,
+                gSwapchain.extent,
+                gInitInfo.bUsePipelines);
+            tRecording = &recording;
+            record(job);
+            tRecording = nullptr;
+            Util::EndCommand(recording.commandBuffer);
+            commandBuffers[job] = recording.commandBuffer;
+        }
+    };
+
+    // The pool is FIFO, so any compile a job ends up waiting on in BindShader was picked up by a
+    // thread before these tasks were
+    std::vector<std::future<void>> futures;
+    futures.reserve(workerCount - 1);
+    for (u32 i = 1; i < workerCount; i++)
+    {
+        futures.emplace_back(threadPool.Submit(
+            [&, i]
+            {
+                recordJobs(workerCommands[i]);
+            }));
+    }
+    recordJobs(workerCommands[0]);
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+
     const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.endRendering();
+    commandBuffer.executeCommands(commandBuffers, gContext.dynamicLoader);
 }
 
 void Swift::SetCullMode(const CullMode& cullMode)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    Render::SetCullMode(commandBuffer, static_cast<vk::CullModeFlagBits>(cullMode));
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    Render::SetCullMode(
+        gContext,
+        commandBuffer,
+        GetRecordingState(),
+        static_cast<vk::CullModeFlagBits>(cullMode));
 }
 
 void Swift::SetDepthCompareOp(DepthCompareOp depthCompareOp)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    Render::SetDepthCompareOp(commandBuffer, static_cast<vk::CompareOp>(depthCompareOp));
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    Render::SetDepthCompareOp(
+        gContext,
+        commandBuffer,
+        GetRecordingState(),
+        static_cast<vk::CompareOp>(depthCompareOp));
 }
 void Swift::SetPolygonMode(PolygonMode polygonMode)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    Render::SetPolygonMode(gContext, commandBuffer, static_cast<vk::PolygonMode>(polygonMode));
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    Render::SetPolygonMode(
+        gContext,
+        commandBuffer,
+        GetRecordingState(),
+        static_cast<vk::PolygonMode>(polygonMode));
+}
+
+void Swift::InvalidateState()
+{
+    Render::GetRenderState(gCurrentFrameData).Reset();
 }
 
 ShaderHandle Swift::CreateGraphicsShader(
@@ -322,43 +1166,192 @@ ShaderHandle Swift::CreateGraphicsShader(
     const std::string_view fragmentPath,
     const std::string_view debugName)
 {
+    auto vertexCode = FileIO::ReadBinaryFile(vertexPath);
+    auto fragmentCode = FileIO::ReadBinaryFile(fragmentPath);
+    const auto hash = HashGraphicsShader(vertexCode, fragmentCode);
+    if (const auto shaderHandle = AcquireCachedShader(hash, vertexCode, fragmentCode))
+    {
+        return *shaderHandle;
+    }
+
     const auto shader = Init::CreateGraphicsShader(
         gContext,
         gDescriptor,
+        gPipelineLayoutCache,
         gInitInfo.bUsePipelines,
-        128,
-        vertexPath,
-        fragmentPath,
+        vertexCode,
+        fragmentCode,
         debugName);
-    gShaders.emplace_back(shader);
-    const auto index = static_cast<u32>(gShaders.size() - 1);
-    return index;
+    return InsertCachedShader(hash, shader, vertexCode, fragmentCode);
 }
 
 ShaderHandle Swift::CreateComputeShader(
     const std::string& computePath,
     const std::string_view debugName)
 {
+    auto computeCode = FileIO::ReadBinaryFile(computePath);
+    const auto hash = HashComputeShader(computeCode);
+    if (const auto shaderHandle = AcquireCachedShader(hash, computeCode))
+    {
+        return *shaderHandle;
+    }
+
     const auto shader = Init::CreateComputeShader(
         gContext,
         gDescriptor,
+        gPipelineLayoutCache,
         gInitInfo.bUsePipelines,
-        128,
-        computePath,
+        computeCode,
         debugName);
-    gShaders.emplace_back(shader);
-    const auto index = static_cast<u32>(gShaders.size() - 1);
-    return index;
+    return InsertCachedShader(hash, shader, computeCode);
+}
+
+ShaderHandle Swift::CreateGraphicsShaderAsync(
+    const std::string_view vertexPath,
+    const std::string_view fragmentPath,
+    const std::string_view debugName)
+{
+    // Reading and hashing stays on the caller so identical shaders still share a handle, the
+    // push constant block is reflected there too so BindShader can vet the fallback
+    auto vertexCode = FileIO::ReadBinaryFile(vertexPath);
+    auto fragmentCode = FileIO::ReadBinaryFile(fragmentPath);
+    const auto hash = HashGraphicsShader(vertexCode, fragmentCode);
+    if (const auto shaderHandle = AcquireCachedShader(hash, vertexCode, fragmentCode))
+    {
+        return *shaderHandle;
+    }
+
+    const auto shaderHandle = InsertCachedShader(hash, Shader(), vertexCode, fragmentCode);
+    const auto pushConstantRange =
+        Vulkan::Util::ReflectGraphicsPushConstantRange(vertexCode, fragmentCode);
+    auto future = GetThreadPool().Submit(
+        [vertexCode = std::move(vertexCode),
+         fragmentCode = std::move(fragmentCode),
+         debugName = std::string(debugName)]() mutable
+        {
+            return Init::CreateGraphicsShader(
+                gContext,
+                gDescriptor,
+                gPipelineLayoutCache,
+                gInitInfo.bUsePipelines,
+                vertexCode,
+                fragmentCode,
+                debugName);
+        });
+    std::scoped_lock lock(gShaderMutex);
+    gPendingShaders.emplace(
+        shaderHandle,
+        PendingShader(std::move(future), false, pushConstantRange));
+    return shaderHandle;
+}
+
+ShaderHandle Swift::CreateComputeShaderAsync(
+    const std::string& computePath,
+    const std::string_view debugName)
+{
+    auto computeCode = FileIO::ReadBinaryFile(computePath);
+    const auto hash = HashComputeShader(computeCode);
+    if (const auto shaderHandle = AcquireCachedShader(hash, computeCode))
+    {
+        return *shaderHandle;
+    }
+
+    const auto shaderHandle = InsertCachedShader(hash, Shader(), computeCode);
+    const auto pushConstantRange = Vulkan::Util::ReflectComputePushConstantRange(computeCode);
+    auto future = GetThreadPool().Submit(
+        [computeCode = std::move(computeCode), debugName = std::string(debugName)]() mutable
+        {
+            return Init::CreateComputeShader(
+                gContext,
+                gDescriptor,
+                gPipelineLayoutCache,
+                gInitInfo.bUsePipelines,
+                computeCode,
+                debugName);
+        });
+    std::scoped_lock lock(gShaderMutex);
+    gPendingShaders.emplace(
+        shaderHandle,
+        PendingShader(std::move(future), true, pushConstantRange));
+    return shaderHandle;
+}
+
+bool Swift::IsShaderReady(const ShaderHandle shaderHandle)
+{
+    return ResolvePendingShader(shaderHandle, false);
+}
+
+void Swift::SetFallbackShader(const ShaderHandle shaderHandle)
+{
+    // A fallback has to be bindable at any time, so it is waited for here
+    ResolvePendingShader(shaderHandle, true);
+    const auto& stageFlags = gShaders.Get(shaderHandle).stageFlags;
+    if (std::ranges::contains(stageFlags, vk::ShaderStageFlagBits::eCompute))
+    {
+        gFallbackComputeShader = shaderHandle;
+    }
+    else
+    {
+        gFallbackGraphicsShader = shaderHandle;
+    }
+}
+
+void Swift::DestroyShader(const ShaderHandle shaderHandle)
+{
+    ResolvePendingShader(shaderHandle, true);
+    // Shared handles are only destroyed once the last creator lets go of them
+    if (const auto it = gCachedShaders.find(shaderHandle); it != gCachedShaders.end())
+    {
+        if (--it->second.refCount > 0)
+        {
+            return;
+        }
+        const auto [begin, end] = gShaderCache.equal_range(it->second.hash);
+        gShaderCache.erase(std::ranges::find(
+            begin,
+            end,
+            shaderHandle,
+            &decltype(gShaderCache)::value_type::second));
+        gCachedShaders.erase(it);
+    }
+
+    const auto shader = gShaders.Get(shaderHandle);
+    gShaders.Remove(shaderHandle);
+    gDeletionQueue.Push(
+        GetPendingGraphicsValue(),
+        [shader, shaderHandle]
+        {
+            shader.Destroy(gContext);
+            gShaders.Release(SlotMap<Shader>::GetIndex(shaderHandle));
+        });
 }
 
 void Swift::BindShader(const ShaderHandle& shaderHandle)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    const auto& shader = gShaders.at(shaderHandle);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    auto boundHandle = shaderHandle;
+    if (!ResolvePendingShader(shaderHandle, false))
+    {
+        if (const auto fallback = GetFallbackShader(shaderHandle); IsValid(fallback))
+        {
+            boundHandle = fallback;
+        }
+        else
+        {
+            ResolvePendingShader(shaderHandle, true);
+        }
+    }
+    const auto& shader = gShaders.Get(boundHandle);
 
-    Render::BindShader(commandBuffer, gContext, gDescriptor, shader, gInitInfo.bUsePipelines);
+    Render::BindShader(
+        commandBuffer,
+        GetRecordingState(),
+        gContext,
+        gDescriptor,
+        shader,
+        gInitInfo.bUsePipelines);
 
-    gCurrentShader = shaderHandle;
+    GetCurrentShader() = boundHandle;
 }
 
 void Swift::Draw(
@@ -367,8 +1360,9 @@ void Swift::Draw(
     const u32 firstVertex,
     const u32 firstInstance)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    commandBuffer
+        .draw(vertexCount, instanceCount, firstVertex, firstInstance, gContext.dynamicLoader);
 }
 
 void Swift::DrawIndexed(
@@ -378,8 +1372,14 @@ void Swift::DrawIndexed(
     const int vertexOffset,
     const u32 firstInstance)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    commandBuffer.drawIndexed(
+        indexCount,
+        instanceCount,
+        firstIndex,
+        vertexOffset,
+        firstInstance,
+        gContext.dynamicLoader);
 }
 
 void Swift::DrawIndexedIndirect(
@@ -388,9 +1388,10 @@ void Swift::DrawIndexedIndirect(
     const u32 drawCount,
     const u32 stride)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    const auto& realBuffer = gBuffers[buffer];
-    commandBuffer.drawIndexedIndirect(realBuffer, offset, drawCount, stride);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    const auto& realBuffer = gBuffers.Get(buffer);
+    commandBuffer
+        .drawIndexedIndirect(realBuffer, offset, drawCount, stride, gContext.dynamicLoader);
 }
 
 void Swift::DrawIndexedIndirectCount(
@@ -401,16 +1402,17 @@ void Swift::DrawIndexedIndirectCount(
     const u32 maxDrawCount,
     const u32 stride)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    const auto& realBuffer = gBuffers[buffer];
-    const auto& realCountBuffer = gBuffers[countBuffer];
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    const auto& realBuffer = gBuffers.Get(buffer);
+    const auto& realCountBuffer = gBuffers.Get(countBuffer);
     commandBuffer.drawIndexedIndirectCount(
         realBuffer,
         offset,
         realCountBuffer,
         countOffset,
         maxDrawCount,
-        stride);
+        stride,
+        gContext.dynamicLoader);
 }
 
 ImageHandle Swift::CreateImage(
@@ -434,56 +1436,33 @@ ImageHandle Swift::CreateImage(
         {},
         debugName);
 
-    u32 arrayElement = 0;
-    switch (usage)
+    std::scoped_lock lock(gImageMutex);
+    if (usage == ImageUsage::eTemporary)
     {
-    case ImageUsage::eSampledReadWrite:
-        gWriteableImages.emplace_back(image);
-        arrayElement = static_cast<u32>(gWriteableImages.size() - 1);
-        Util::UpdateDescriptorImage(
-            gDescriptor.set,
-            image.imageView,
-            gLinearSampler,
-            arrayElement,
-            gContext);
+        return PackImageType(gTemporaryImages.Insert(image), ImageUsage::eTemporary);
+    }
 
-        gSamplerImages.emplace_back(image);
-        arrayElement = static_cast<u32>(gSamplerImages.size() - 1);
-        Util::UpdateDescriptorSampler(
-            gDescriptor.set,
-            image.imageView,
-            gLinearSampler,
-            arrayElement,
-            gContext);
-        return PackImageType(arrayElement, ImageUsage::eSampledReadWrite);
-        
-    case ImageUsage::eReadWrite:
-        arrayElement = static_cast<u32>(gWriteableImages.size() - 1);
+    const auto slot = gImages.Insert(image);
+    const auto arrayElement = ImagePool::GetIndex(slot);
+    if (usage == ImageUsage::eSampledReadWrite || usage == ImageUsage::eReadWrite)
+    {
         Util::UpdateDescriptorImage(
             gDescriptor.set,
             image.imageView,
             gLinearSampler,
             arrayElement,
             gContext);
-        gWriteableImages.emplace_back(image);
-        return PackImageType(arrayElement, ImageUsage::eReadWrite);
-    case ImageUsage::eSampled:
-        gSamplerImages.emplace_back(image);
-        arrayElement = static_cast<u32>(gSamplerImages.size() - 1);
+    }
+    if (usage == ImageUsage::eSampledReadWrite || usage == ImageUsage::eSampled)
+    {
         Util::UpdateDescriptorSampler(
             gDescriptor.set,
             image.imageView,
             gLinearSampler,
             arrayElement,
             gContext);
-        return PackImageType(arrayElement, ImageUsage::eSampled);
-    case ImageUsage::eTemporary:
-        gTemporaryImages.emplace_back(image);
-        arrayElement = static_cast<u32>(gTemporaryImages.size() - 1);
-        return PackImageType(arrayElement, ImageUsage::eTemporary);
     }
-    assert(false);
-    return {};
+    return PackImageType(slot, usage);
 }
 
 ImageHandle Swift::LoadImageFromFile(
@@ -514,86 +1493,346 @@ ImageHandle Swift::LoadImageFromFileQueued(
     const bool tempImage,
     const ThreadHandle thread)
 {
-    Thread loadThread;
+    Thread* loadThread = nullptr;
     if (thread != -1)
     {
-        loadThread = gThreadDatas[thread];
+        loadThread = &gThreadDatas[thread];
     }
 
-    const auto transferQueue = loadThread.command.commandBuffer ? loadThread.queue : gTransferQueue;
-    const auto transferCommand =
-        loadThread.command.commandBuffer ? loadThread.command : gTransferCommand;
+    const auto transferQueue = loadThread ? loadThread->queue : gTransferQueue;
+    const auto transferCommand = loadThread ? loadThread->command : gTransferCommand;
+    auto& stagingRing = loadThread ? loadThread->stagingRing : gTransferStagingRing;
 
-    Image image;
-    Buffer staging;
-    if (filePath.extension() == ".dds")
+    // Thread contexts upload on a graphics queue, so only the shared transfer queue may need to
+    // hand the image over to the graphics family
+    const auto dstQueueFamily = loadThread ? transferQueue.index : gGraphicsQueue.index;
+
+    if (filePath.extension() != ".dds")
     {
-        std::tie(image, staging) = Init::CreateDDSImage(
-            gContext,
-            transferQueue,
-            transferCommand,
-            filePath,
-            mipLevel,
-            loadAllMipMaps,
-            debugName);
+        return InvalidHandle;
+    }
+    const auto result = Init::CreateDDSImage(
+        gContext,
+        transferQueue,
+        transferCommand,
+        dstQueueFamily,
+        filePath,
+        mipLevel,
+        loadAllMipMaps,
+        stagingRing,
+        gTransferTicket + 1,
+        debugName);
+    if (!result)
+    {
+        return InvalidHandle;
+    }
+    const auto& [image, staging, releaseBarrier] = result.value();
+
+    std::scoped_lock lock(gImageMutex);
+    if (loadThread)
+    {
+        if (staging.buffer)
+        {
+            loadThread->stagingBuffers.emplace_back(staging);
+        }
+    }
+    else
+    {
+        if (staging.buffer)
+        {
+            gTransferStagingBuffers.emplace_back(gTransferTicket + 1, staging);
+        }
+        if (transferQueue.index != dstQueueFamily)
+        {
+            gTransferAcquireBarriers.emplace_back(releaseBarrier);
+        }
     }
-    gTransferStagingBuffers.emplace_back(staging);
 
-    u32 arrayElement;
     if (tempImage)
     {
-        gTemporaryImages.emplace_back(image);
-        arrayElement = static_cast<u32>(gTemporaryImages.size() - 1);
-        return PackImageType(arrayElement, ImageUsage::eTemporary);
+        return PackImageType(gTemporaryImages.Insert(image), ImageUsage::eTemporary);
     }
 
-    gSamplerImages.emplace_back(image);
-    arrayElement = static_cast<u32>(gSamplerImages.size() - 1);
+    const auto slot = gImages.Insert(image);
     Util::UpdateDescriptorSampler(
         gDescriptor.set,
-        gSamplerImages.back().imageView,
+        image.imageView,
         gLinearSampler,
-        arrayElement,
+        ImagePool::GetIndex(slot),
         gContext);
-    return PackImageType(arrayElement, ImageUsage::eSampled);
+    return PackImageType(slot, ImageUsage::eSampled);
 }
 
-ImageHandle Swift::LoadCubemapFromFile(
+std::vector<ImageHandle> Swift::LoadImagesFromFiles(
+    const std::span<const std::string> filePaths,
+    const int mipLevel,
+    const bool loadAllMipMaps)
+{
+    // The batch takes the next ticket, an open BeginTransfer would already have claimed it
+    assert(!gRecordingTransfer && "LoadImagesFromFiles called inside BeginTransfer/EndTransfer");
+    if (filePaths.empty())
+    {
+        return {};
+    }
+    if (gLoadWorkers.empty())
+    {
+        CreateLoadWorkers();
+    }
+
+    using LoadResult = std::tuple<
+        Image,
+        Buffer,
+        vk::ImageMemoryBarrier2>;
+    // Stays empty for files that could not be loaded
+    std::vector<std::optional<LoadResult>> results(filePaths.size());
+    const auto batchTicket = gTransferTicket + 1;
+    std::atomic<u32> nextPath = 0;
+
+    const auto workerCount =
+        std::min(static_cast<u32>(gLoadWorkers.size()), static_cast<u32>(filePaths.size()));
+    std::vector<std::future<void>> futures;
+    futures.reserve(workerCount);
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        auto& worker = gLoadWorkers[i];
+        // The command buffer may still be executing the previous batch
+        Util::WaitSemaphore(gContext, gTransferTimeline, worker.ticket);
+        worker.stagingRing.Reclaim(worker.ticket);
+        futures.emplace_back(gThreadPool->Submit(
+            [&, &worker = worker]
+            {
+                Util::BeginOneTimeCommand(worker.command);
+                for (auto index = nextPath++; index < filePaths.size(); index = nextPath++)
+                {
+                    const auto& path = filePaths[index];
+                    if (std::filesystem::path(path).extension() != ".dds")
+                    {
+                        continue;
+                    }
+                    results[index] = Init::CreateDDSImage(
+                        gContext,
+                        gTransferQueue,
+                        worker.command,
+                        gGraphicsQueue.index,
+                        path,
+                        mipLevel,
+                        loadAllMipMaps,
+                        worker.stagingRing,
+                        batchTicket,
+                        path);
+                }
+                Util::EndCommand(worker.command);
+            }));
+    }
+
+    std::vector<vk::CommandBuffer> commandBuffers;
+    commandBuffers.reserve(workerCount);
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        futures[i].get();
+        commandBuffers.emplace_back(gLoadWorkers[i].command.commandBuffer);
+    }
+
+    // Queue submission is externally synchronized, so the workers only record
+    const auto ticket = ++gTransferTicket;
+    const auto signalInfo = vk::SemaphoreSubmitInfo()
+                                .setSemaphore(gTransferTimeline)
+                                .setValue(ticket)
+                                .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+    Util::SubmitQueue(gTransferQueue, commandBuffers, {}, signalInfo, nullptr);
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        gLoadWorkers[i].ticket = ticket;
+    }
+
+    std::scoped_lock lock(gImageMutex);
+    std::vector<ImageHandle> handles;
+    std::vector<vk::ImageView> imageViews;
+    std::vector<u32> arrayElements;
+    handles.reserve(results.size());
+    imageViews.reserve(results.size());
+    arrayElements.reserve(results.size());
+    for (const auto& result : results)
+    {
+        if (!result)
+        {
+            handles.emplace_back(InvalidHandle);
+            continue;
+        }
+        const auto& [image, staging, releaseBarrier] = result.value();
+        const auto slot = gImages.Insert(image);
+        handles.emplace_back(PackImageType(slot, ImageUsage::eSampled));
+        imageViews.emplace_back(image.imageView);
+        arrayElements.emplace_back(ImagePool::GetIndex(slot));
+        if (staging.buffer)
+        {
+            gTransferStagingBuffers.emplace_back(ticket, staging);
+        }
+        if (gTransferQueue.index != gGraphicsQueue.index)
+        {
+            gPendingAcquireBarriers.emplace_back(releaseBarrier);
+        }
+    }
+    Util::UpdateDescriptorSamplers(
+        gDescriptor.set,
+        imageViews,
+        arrayElements,
+        gLinearSampler,
+        gContext);
+    if (gRecordingFrame)
+    {
+        RecordPendingAcquires(Render::GetCommandBuffer(gCurrentFrameData));
+    }
+    return handles;
+}
+
+ImageHandle Swift::LoadImageFromFileProgressive(
     const std::filesystem::path& filePath,
+    const int residentMip,
     const std::string_view debugName)
 {
     Swift::BeginTransfer(-1);
+    const auto result = Init::CreateProgressiveDDSImage(
+        gContext,
+        gTransferQueue,
+        gTransferCommand,
+        gGraphicsQueue.index,
+        filePath,
+        residentMip,
+        gTransferStagingRing,
+        gTransferTicket + 1,
+        debugName);
+    if (!result)
+    {
+        Swift::EndTransfer(-1);
+        return InvalidHandle;
+    }
+    const auto& [image, staging, releaseBarrier] = result.value();
+    if (staging.buffer)
+    {
+        gTransferStagingBuffers.emplace_back(gTransferTicket + 1, staging);
+    }
+    if (gTransferQueue.index != gGraphicsQueue.index)
+    {
+        gTransferAcquireBarriers.emplace_back(releaseBarrier);
+    }
+    Swift::EndTransfer(-1);
+
+    std::scoped_lock lock(gImageMutex);
+    const auto slot = gImages.Insert(image);
+    Util::UpdateDescriptorSampler(
+        gDescriptor.set,
+        image.imageView,
+        gLinearSampler,
+        ImagePool::GetIndex(slot),
+        gContext);
+    return PackImageType(slot, ImageUsage::eSampled);
+}
+
+bool Swift::LoadImageMipQueued(
+    const ImageHandle imageHandle,
+    const int mipLevel)
+{
+    assert(gRecordingTransfer && "LoadImageMipQueued called outside BeginTransfer/EndTransfer");
     Image image;
-    Buffer staging;
+    {
+        std::scoped_lock lock(gImageMutex);
+        image = GetRealImage(imageHandle);
+    }
+    const auto result = Init::UploadDDSMip(
+        gContext,
+        gTransferQueue,
+        gTransferCommand,
+        gGraphicsQueue.index,
+        image,
+        mipLevel,
+        gTransferStagingRing,
+        gTransferTicket + 1);
+    if (!result)
+    {
+        return false;
+    }
+    const auto& [staging, releaseBarrier] = result.value();
+
+    std::scoped_lock lock(gImageMutex);
+    if (staging.buffer)
+    {
+        gTransferStagingBuffers.emplace_back(gTransferTicket + 1, staging);
+    }
+    if (gTransferQueue.index != gGraphicsQueue.index)
+    {
+        gTransferAcquireBarriers.emplace_back(releaseBarrier);
+    }
+    return true;
+}
+
+void Swift::SetImageMinLod(
+    const ImageHandle imageHandle,
+    const int minLod)
+{
+    std::scoped_lock lock(gImageMutex);
+    const auto& realImage = GetRealImage(imageHandle);
+    assert(minLod >= 0 && minLod < static_cast<int>(realImage.mipLevels));
+    if (realImage.minLod == minLod)
+    {
+        gPendingMinLods.erase(imageHandle);
+        return;
+    }
+    gPendingMinLods.insert_or_assign(imageHandle, minLod);
+}
+
+ImageHandle Swift::LoadCubemapFromFile(
+    const std::filesystem::path& filePath,
+    const std::string_view debugName)
+{
     assert(filePath.extension() == ".dds");
-    if (filePath.extension() == ".dds")
+    Swift::BeginTransfer(-1);
+    const auto result = Init::CreateDDSImage(
+        gContext,
+        gTransferQueue,
+        gTransferCommand,
+        gGraphicsQueue.index,
+        filePath,
+        0,
+        true,
+        gTransferStagingRing,
+        gTransferTicket + 1,
+        debugName);
+    if (!result)
     {
-        std::tie(image, staging) = Init::CreateDDSImage(
-            gContext,
-            gTransferQueue,
-            gTransferCommand,
-            filePath,
-            0,
-            true,
-            debugName);
+        Swift::EndTransfer(-1);
+        return InvalidHandle;
+    }
+    const auto& [image, staging, releaseBarrier] = result.value();
+    if (staging.buffer)
+    {
+        gTransferStagingBuffers.emplace_back(gTransferTicket + 1, staging);
+    }
+    if (gTransferQueue.index != gGraphicsQueue.index)
+    {
+        gTransferAcquireBarriers.emplace_back(releaseBarrier);
     }
     Swift::EndTransfer(-1);
-    staging.Destroy(gContext);
 
-    gSamplerImages.emplace_back(image);
-    const auto arrayElement = static_cast<u32>(gSamplerImages.size() - 1);
+    std::scoped_lock lock(gImageMutex);
+    const auto slot = gImages.Insert(image);
     Util::UpdateDescriptorSampler(
         gDescriptor.set,
-        gSamplerImages.back().imageView,
+        image.imageView,
         gLinearSampler,
-        arrayElement,
+        ImagePool::GetIndex(slot),
         gContext);
 
-    return PackImageType(arrayElement, ImageUsage::eSampled);
+    return PackImageType(slot, ImageUsage::eSampled);
 }
 
 int Swift::GetMinLod(const ImageHandle image)
 {
+    std::scoped_lock lock(gImageMutex);
+    if (const auto it = gPendingMinLods.find(image); it != gPendingMinLods.end())
+    {
+        return it->second;
+    }
     return GetRealImage(image).minLod;
 }
 
@@ -612,19 +1851,47 @@ std::string_view Swift::GetURI(const ImageHandle imageHandle)
     return GetRealImage(imageHandle).uri;
 }
 
+glm::uvec2 Swift::GetImageSize(const ImageHandle imageHandle)
+{
+    const auto& extent = GetRealImage(imageHandle).extent;
+    return {extent.width, extent.height};
+}
+
+u64 Swift::GetImageMemorySize(const ImageHandle imageHandle)
+{
+    const auto& realImage = GetRealImage(imageHandle);
+    VmaAllocationInfo allocationInfo;
+    vmaGetAllocationInfo(gContext.allocator, realImage.imageAllocation, &allocationInfo);
+    return allocationInfo.size;
+}
+
 ImageHandle Swift::ReadOnlyImageFromIndex(const int imageIndex)
 {
-    return PackImageType(imageIndex, ImageUsage::eSampled);
+    std::scoped_lock lock(gImageMutex);
+    if (imageIndex < 0 || !gImages.IsAlive(static_cast<u32>(imageIndex)))
+    {
+        return InvalidHandle;
+    }
+    return PackImageType(gImages.HandleFromIndex(imageIndex), ImageUsage::eSampled);
 }
 
 void Swift::UpdateImage(
     const ImageHandle baseImage,
     const ImageHandle tempImage)
 {
+    std::scoped_lock lock(gImageMutex);
+    // The new image brings its own view, a min LOD queued for the old one no longer applies
+    gPendingMinLods.erase(baseImage);
     auto& realBaseImage = GetRealImage(baseImage);
-    realBaseImage.Destroy(gContext);
-    const auto& realTempImage = GetRealImage(tempImage);
-    realBaseImage = realTempImage;
+    gDeletionQueue.Push(
+        GetPendingGraphicsValue(),
+        [oldImage = realBaseImage]() mutable
+        {
+            oldImage.Destroy(gContext);
+        });
+    realBaseImage = GetRealImage(tempImage);
+    // The base slot owns the image now, so only the temporary slot is released
+    GetImagePool(tempImage).Erase(GetImageSlot(tempImage));
     Util::UpdateDescriptorSampler(
         gDescriptor.set,
         realBaseImage.imageView,
@@ -635,19 +1902,44 @@ void Swift::UpdateImage(
 
 void Swift::ClearTempImages()
 {
-    gTemporaryImages.clear();
+    std::scoped_lock lock(gImageMutex);
+    gTemporaryImages.ForEach(
+        [](const Image& image)
+        {
+            gDeletionQueue.Push(
+                GetPendingGraphicsValue(),
+                [image]() mutable
+                {
+                    image.Destroy(gContext);
+                });
+        });
+    gTemporaryImages.Clear();
 }
 
 void Swift::DestroyImage(const ImageHandle imageHandle)
 {
-    auto& realImage = GetRealImage(imageHandle);
-    realImage.Destroy(gContext);
+    std::scoped_lock lock(gImageMutex);
+    gPendingMinLods.erase(imageHandle);
+    auto& pool = GetImagePool(imageHandle);
+    const auto slot = GetImageSlot(imageHandle);
+    // The handle goes stale right away, but the descriptor index is only reused once no frame in
+    // flight can still sample from it
+    gDeletionQueue.Push(
+        GetPendingGraphicsValue(),
+        [image = pool.Get(slot), &pool, slot]() mutable
+        {
+            image.Destroy(gContext);
+            std::scoped_lock releaseLock(gImageMutex);
+            pool.Release(ImagePool::GetIndex(slot));
+        });
+    pool.Remove(slot);
 }
 
 BufferHandle Swift::CreateBuffer(
     const BufferType bufferType,
     const u32 size,
-    const std::string_view debugName)
+    const std::string_view debugName,
+    const bool bComputeShared)
 {
     vk::BufferUsageFlags bufferUsageFlags = vk::BufferUsageFlagBits::eShaderDeviceAddress |
                                             vk::BufferUsageFlagBits::eTransferDst |
@@ -672,33 +1964,45 @@ BufferHandle Swift::CreateBuffer(
         break;
     }
 
+    // Only a separate compute family needs the buffer shared
+    std::vector<u32> concurrentQueueFamilies;
+    if (bComputeShared && gComputeQueue.index != gGraphicsQueue.index)
+    {
+        concurrentQueueFamilies = {gGraphicsQueue.index, gComputeQueue.index};
+    }
     const auto buffer = Init::CreateBuffer(
         gContext,
         gGraphicsQueue.index,
         size,
         bufferUsageFlags,
         readback,
-        debugName);
-    gBuffers.emplace_back(buffer);
-    const auto index = static_cast<u32>(gBuffers.size() - 1);
-    return index;
+        debugName,
+        concurrentQueueFamilies);
+    return gBuffers.Insert(buffer);
 }
 
 void Swift::DestroyBuffer(const BufferHandle bufferHandle)
 {
-    const auto& realBuffer = gBuffers.at(bufferHandle);
-    realBuffer.Destroy(gContext);
+    const auto realBuffer = gBuffers.Get(bufferHandle);
+    gBuffers.Remove(bufferHandle);
+    gDeletionQueue.Push(
+        GetPendingGraphicsValue(),
+        [realBuffer, bufferHandle]
+        {
+            realBuffer.Destroy(gContext);
+            gBuffers.Release(SlotMap<Buffer>::GetIndex(bufferHandle));
+        });
 }
 
 void* Swift::MapBuffer(const BufferHandle bufferHandle)
 {
-    const auto& realBuffer = gBuffers.at(bufferHandle);
+    const auto& realBuffer = gBuffers.Get(bufferHandle);
     return Util::MapBuffer(gContext, realBuffer);
 }
 
 void Swift::UnmapBuffer(const BufferHandle bufferHandle)
 {
-    const auto& realBuffer = gBuffers.at(bufferHandle);
+    const auto& realBuffer = gBuffers.Get(bufferHandle);
     Util::UnmapBuffer(gContext, realBuffer);
 }
 
@@ -708,7 +2012,7 @@ void Swift::UploadToBuffer(
     const u64 offset,
     const u64 size)
 {
-    const auto& realBuffer = gBuffers.at(buffer);
+    const auto& realBuffer = gBuffers.Get(buffer);
     Util::UploadToBuffer(gContext, data, realBuffer, offset, size);
 }
 
@@ -727,7 +2031,7 @@ void Swift::DownloadBuffer(
     const u64 offset,
     const u64 size)
 {
-    const auto& realBuffer = gBuffers.at(buffer);
+    const auto& realBuffer = gBuffers.Get(buffer);
     vmaCopyAllocationToMemory(gContext.allocator, realBuffer.allocation, offset, data, size);
 }
 
@@ -737,9 +2041,9 @@ void Swift::UpdateSmallBuffer(
     const u64 size,
     const void* data)
 {
-    const auto& realBuffer = gBuffers.at(buffer);
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.updateBuffer(realBuffer, offset, size, data);
+    const auto& realBuffer = gBuffers.Get(buffer);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    commandBuffer.updateBuffer(realBuffer, offset, size, data, gContext.dynamicLoader);
 }
 
 void Swift::CopyBuffer(
@@ -751,29 +2055,37 @@ void Swift::CopyBuffer(
 {
     const auto region =
         vk::BufferCopy2().setSize(size).setSrcOffset(srcOffset).setDstOffset(dstOffset);
-    const auto& realSrcBuffer = gBuffers.at(srcBufferHandle);
-    const auto& realDstBuffer = gBuffers.at(dstBufferHandle);
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    const auto& realSrcBuffer = gBuffers.Get(srcBufferHandle);
+    const auto& realDstBuffer = gBuffers.Get(dstBufferHandle);
+    const auto commandBuffer = GetRecordingCommandBuffer();
 
     commandBuffer.copyBuffer2(
         vk::CopyBufferInfo2()
             .setSrcBuffer(realSrcBuffer)
             .setDstBuffer(realDstBuffer)
-            .setRegions(region));
+            .setRegions(region),
+        gContext.dynamicLoader);
 }
 
 u64 Swift::GetBufferAddress(const BufferHandle& buffer)
 {
-    const auto& realBuffer = gBuffers.at(buffer);
+    const auto& realBuffer = gBuffers.Get(buffer);
     const auto addressInfo = vk::BufferDeviceAddressInfo().setBuffer(realBuffer.buffer);
     return gContext.device.getBufferAddress(addressInfo);
 }
 
+void Swift::BufferBarrier(const BufferHandle bufferHandle)
+{
+    const auto& realBuffer = gBuffers.Get(bufferHandle);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    Util::PipelineBarrier(gContext, commandBuffer, Util::BufferBarrier(realBuffer));
+}
+
 void Swift::BindIndexBuffer(const BufferHandle& bufferObject)
 {
-    const auto& realBuffer = gBuffers.at(bufferObject);
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.bindIndexBuffer(realBuffer, 0, vk::IndexType::eUint32);
+    const auto& realBuffer = gBuffers.Get(bufferObject);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    commandBuffer.bindIndexBuffer(realBuffer, 0, vk::IndexType::eUint32, gContext.dynamicLoader);
 }
 
 void Swift::ClearImage(
@@ -787,17 +2099,17 @@ void Swift::ClearImage(
         vk::ImageLayout::eGeneral,
         realImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, generalBarrier);
+    Util::PipelineBarrier(gContext, commandBuffer, generalBarrier);
 
     const auto clearColor = vk::ClearColorValue(color.x, color.y, color.z, color.w);
-    Util::ClearColorImage(commandBuffer, realImage, clearColor);
+    Util::ClearColorImage(gContext, commandBuffer, realImage, clearColor);
 
     const auto colorBarrier = Util::ImageBarrier(
         vk::ImageLayout::eGeneral,
         vk::ImageLayout::eColorAttachmentOptimal,
         realImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, colorBarrier);
+    Util::PipelineBarrier(gContext, commandBuffer, colorBarrier);
 }
 
 void Swift::ClearSwapchainImage(const glm::vec4 color)
@@ -808,17 +2120,21 @@ void Swift::ClearSwapchainImage(const glm::vec4 color)
         vk::ImageLayout::eGeneral,
         Render::GetSwapchainImage(gSwapchain),
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, generalBarrier);
+    Util::PipelineBarrier(gContext, commandBuffer, generalBarrier);
 
     const auto clearColor = vk::ClearColorValue(color.x, color.y, color.z, color.w);
-    Util::ClearColorImage(commandBuffer, Render::GetSwapchainImage(gSwapchain), clearColor);
+    Util::ClearColorImage(
+        gContext,
+        commandBuffer,
+        Render::GetSwapchainImage(gSwapchain),
+        clearColor);
 
     const auto colorBarrier = Util::ImageBarrier(
         vk::ImageLayout::eGeneral,
         vk::ImageLayout::eColorAttachmentOptimal,
         Render::GetSwapchainImage(gSwapchain),
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, colorBarrier);
+    Util::PipelineBarrier(gContext, commandBuffer, colorBarrier);
 }
 
 void Swift::CopyImage(
@@ -841,8 +2157,15 @@ void Swift::CopyImage(
         dstLayout,
         dstImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, {srcBarrier, dstBarrier});
-    Util::CopyImage(commandBuffer, srcImage, srcLayout, dstImage, dstLayout, Util::To2D(extent));
+    Util::PipelineBarrier(gContext, commandBuffer, {srcBarrier, dstBarrier});
+    Util::CopyImage(
+        gContext,
+        commandBuffer,
+        srcImage,
+        srcLayout,
+        dstImage,
+        dstLayout,
+        Util::To2D(extent));
 }
 
 void Swift::CopyToSwapchain(
@@ -864,8 +2187,15 @@ void Swift::CopyToSwapchain(
         dstLayout,
         dstImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, {srcBarrier, dstBarrier});
-    Util::CopyImage(commandBuffer, srcImage, srcLayout, dstImage, dstLayout, Util::To2D(extent));
+    Util::PipelineBarrier(gContext, commandBuffer, {srcBarrier, dstBarrier});
+    Util::CopyImage(
+        gContext,
+        commandBuffer,
+        srcImage,
+        srcLayout,
+        dstImage,
+        dstLayout,
+        Util::To2D(extent));
 }
 
 void Swift::BlitImage(
@@ -890,8 +2220,9 @@ void Swift::BlitImage(
         dstLayout,
         dstImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, {srcBarrier, dstBarrier});
+    Util::PipelineBarrier(gContext, commandBuffer, {srcBarrier, dstBarrier});
     Util::BlitImage(
+        gContext,
         commandBuffer,
         srcImage,
         srcLayout,
@@ -921,8 +2252,9 @@ void Swift::BlitToSwapchain(
         dstLayout,
         dstImage,
         vk::ImageAspectFlagBits::eColor);
-    Util::PipelineBarrier(commandBuffer, {srcBarrier, dstBarrier});
+    Util::PipelineBarrier(gContext, commandBuffer, {srcBarrier, dstBarrier});
     Util::BlitImage(
+        gContext,
         commandBuffer,
         srcImage,
         srcLayout,
@@ -932,73 +2264,276 @@ void Swift::BlitToSwapchain(
         gSwapchain.extent);
 }
 
+void Swift::CopySwapchainToBuffer(const BufferHandle dstBufferHandle)
+{
+    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    constexpr auto srcLayout = vk::ImageLayout::eTransferSrcOptimal;
+    auto& srcImage = Render::GetSwapchainImage(gSwapchain);
+    const auto& realDstBuffer = gBuffers.Get(dstBufferHandle);
+    const auto srcBarrier = Util::ImageBarrier(
+        srcImage.currentLayout,
+        srcLayout,
+        srcImage,
+        vk::ImageAspectFlagBits::eColor);
+    Util::PipelineBarrier(gContext, commandBuffer, srcBarrier);
+
+    const auto region =
+        vk::BufferImageCopy2()
+            .setImageSubresource(Util::GetImageSubresourceLayers(vk::ImageAspectFlagBits::eColor))
+            .setImageExtent(vk::Extent3D(gSwapchain.extent, 1));
+    commandBuffer.copyImageToBuffer2(
+        vk::CopyImageToBufferInfo2()
+            .setSrcImage(srcImage)
+            .setSrcImageLayout(srcLayout)
+            .setDstBuffer(realDstBuffer)
+            .setRegions(region),
+        gContext.dynamicLoader);
+}
+
+void Swift::CopyDepthToBuffer(const BufferHandle dstBufferHandle)
+{
+    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
+    constexpr auto srcLayout = vk::ImageLayout::eTransferSrcOptimal;
+    // Rendering does not track the layout it leaves the depth in, which is always the attachment
+    // layout, so the copy hands it back in that layout too
+    constexpr auto depthLayout = vk::ImageLayout::eDepthAttachmentOptimal;
+    auto& depthImage = gSwapchain.depthImage;
+    const auto& realDstBuffer = gBuffers.Get(dstBufferHandle);
+    const auto srcBarrier =
+        Util::ImageBarrier(depthLayout, srcLayout, depthImage, vk::ImageAspectFlagBits::eDepth);
+    Util::PipelineBarrier(gContext, commandBuffer, srcBarrier);
+
+    const auto region =
+        vk::BufferImageCopy2()
+            .setImageSubresource(Util::GetImageSubresourceLayers(vk::ImageAspectFlagBits::eDepth))
+            .setImageExtent(vk::Extent3D(gSwapchain.extent, 1));
+    commandBuffer.copyImageToBuffer2(
+        vk::CopyImageToBufferInfo2()
+            .setSrcImage(depthImage)
+            .setSrcImageLayout(srcLayout)
+            .setDstBuffer(realDstBuffer)
+            .setRegions(region),
+        gContext.dynamicLoader);
+
+    const auto depthBarrier =
+        Util::ImageBarrier(srcLayout, depthLayout, depthImage, vk::ImageAspectFlagBits::eDepth);
+    Util::PipelineBarrier(gContext, commandBuffer, depthBarrier);
+}
+
 void Swift::DispatchCompute(
     const u32 x,
     const u32 y,
     const u32 z)
 {
-    const auto commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    commandBuffer.dispatch(x, y, z);
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    commandBuffer.dispatch(x, y, z, gContext.dynamicLoader);
 }
 
 void Swift::PushConstant(
     const void* value,
     const u32 size)
 {
-    const auto& commandBuffer = Render::GetCommandBuffer(gCurrentFrameData);
-    const auto& [shaders, stageFlags, pipeline, pipelineLayout] = gShaders.at(gCurrentShader);
-
-    vk::ShaderStageFlags pushStageFlags;
-    if (std::ranges::find(stageFlags, vk::ShaderStageFlagBits::eVertex) != stageFlags.end())
+    const auto commandBuffer = GetRecordingCommandBuffer();
+    const auto& shader = gShaders.Get(GetCurrentShader());
+    const auto& pushConstantRange = shader.pushConstantRange;
+    assert(pushConstantRange.size > 0 && "Bound shader does not declare a push constant block");
+    // The C++ struct may carry trailing padding the shader block does not declare
+    const auto [offset, changedSize] = GetRecordingState()
+                                           .UpdatePushConstants(
+                                               shader.pipelineLayout,
+                                               value,
+                                               std::min(size, pushConstantRange.size));
+    if (changedSize == 0)
     {
-        pushStageFlags = vk::ShaderStageFlagBits::eAllGraphics;
+        return;
     }
-    else if (std::ranges::find(stageFlags, vk::ShaderStageFlagBits::eCompute) != stageFlags.end())
+    commandBuffer.pushConstants(
+        shader.pipelineLayout,
+        pushConstantRange.stageFlags,
+        offset,
+        changedSize,
+        static_cast<const char*>(value) + offset,
+        gContext.dynamicLoader);
+}
+
+void Swift::BeginTransfer(const ThreadHandle threadHandle)
+{
+    if (threadHandle != -1)
     {
-        pushStageFlags = vk::ShaderStageFlagBits::eCompute;
+        Util::BeginOneTimeCommand(gThreadDatas[threadHandle].command);
+        return;
     }
 
-    commandBuffer.pushConstants(pipelineLayout, pushStageFlags, 0, size, value);
+    gTransferCommand = gTransferCommands[gTransferCommandIndex];
+    // Only blocks when every transfer command buffer is still in flight
+    Util::WaitSemaphore(gContext, gTransferTimeline, gTransferCommandTickets[gTransferCommandIndex]);
+    RetireTransfers();
+    Util::BeginOneTimeCommand(gTransferCommand);
+    gRecordingTransfer = true;
 }
 
-void Swift::BeginTransfer(const ThreadHandle threadHandle)
+TransferTicket Swift::EndTransfer(const ThreadHandle threadHandle)
 {
     if (threadHandle != -1)
     {
-        Util::BeginOneTimeCommand(gThreadDatas[threadHandle].command);
+        // Thread contexts upload on their own graphics queue and stay blocking
+        auto& thread = gThreadDatas[threadHandle];
+        Util::EndCommand(thread.command);
+        const auto signalInfo = vk::SemaphoreSubmitInfo()
+                                    .setSemaphore(thread.timeline)
+                                    .setValue(++thread.ticket)
+                                    .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        Util::SubmitQueue(thread.queue, thread.command.commandBuffer, {}, signalInfo, nullptr);
+        Util::WaitSemaphore(gContext, thread.timeline, thread.ticket);
+        thread.stagingRing.Reclaim(std::numeric_limits<u64>::max());
+        for (const auto& buffer : thread.stagingBuffers)
+        {
+            buffer.Destroy(gContext);
+        }
+        thread.stagingBuffers.clear();
+        return 0;
     }
-    else
+
+    Util::EndCommand(gTransferCommand);
+    gRecordingTransfer = false;
+    const auto ticket = ++gTransferTicket;
+    const auto signalInfo = vk::SemaphoreSubmitInfo()
+                                .setSemaphore(gTransferTimeline)
+                                .setValue(ticket)
+                                .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+    Util::SubmitQueue(gTransferQueue, gTransferCommand.commandBuffer, {}, signalInfo, nullptr);
+    gTransferCommandTickets[gTransferCommandIndex] = ticket;
+    gTransferCommandIndex = (gTransferCommandIndex + 1) % gTransferCommands.size();
+
+    // The matching acquires go into a graphics command buffer whose submit waits on this ticket
+    gPendingAcquireBarriers.insert(
+        gPendingAcquireBarriers.end(),
+        gTransferAcquireBarriers.begin(),
+        gTransferAcquireBarriers.end());
+    gTransferAcquireBarriers.clear();
+    if (gRecordingFrame)
     {
-        Util::BeginOneTimeCommand(gTransferCommand);
+        RecordPendingAcquires(Render::GetCommandBuffer(gCurrentFrameData));
     }
+    return ticket;
 }
 
-void Swift::EndTransfer(const ThreadHandle threadHandle)
+bool Swift::IsTransferComplete(const TransferTicket ticket)
 {
-    Command transferCommand;
-    Queue transferQueue;
-    vk::Fence transferFence;
-    if (threadHandle != -1)
+    return Util::GetSemaphoreValue(gContext, gTransferTimeline) >= ticket;
+}
+
+void Swift::WaitTransfer(const TransferTicket ticket)
+{
+    Util::WaitSemaphore(gContext, gTransferTimeline, ticket);
+}
+
+void Swift::BeginCompute()
+{
+    assert(!tRecording && "BeginCompute called while another command buffer is being recorded");
+    const auto& computeCommand = gComputeCommands[gComputeCommandIndex];
+    // Only blocks when every compute command buffer is still in flight
+    Util::WaitSemaphore(gContext, gComputeTimeline, gComputeCommandTickets[gComputeCommandIndex]);
+    Util::BeginOneTimeCommand(computeCommand);
+
+    // Releases from the frame being recorded stay pending. This batch would wait for that frame
+    // while the frame waits for this batch.
+    std::vector<vk::BufferMemoryBarrier2> acquireBarriers;
+    std::erase_if(
+        gPendingComputeAcquires,
+        [&acquireBarriers](const std::pair<u64, vk::BufferMemoryBarrier2>& acquire)
+        {
+            if (acquire.first > gGraphicsTimelineValue)
+            {
+                return false;
+            }
+            acquireBarriers.emplace_back(acquire.second);
+            gComputeGraphicsWaitValue = std::max(gComputeGraphicsWaitValue, acquire.first);
+            return true;
+        });
+    if (!acquireBarriers.empty())
     {
-        transferQueue = gThreadDatas[threadHandle].queue;
-        transferCommand = gThreadDatas[threadHandle].command;
-        transferFence = gThreadDatas[threadHandle].fence;
+        Util::PipelineBarrier(gContext, computeCommand, acquireBarriers);
     }
-    else
+
+    gComputeRecording.commandBuffer = computeCommand;
+    gComputeRecording.state.Reset();
+    gComputeRecording.currentShader = InvalidHandle;
+    tRecording = &gComputeRecording;
+}
+
+ComputeTicket Swift::EndCompute()
+{
+    assert(tRecording == &gComputeRecording && "EndCompute called without BeginCompute");
+    tRecording = nullptr;
+    const auto& computeCommand = gComputeCommands[gComputeCommandIndex];
+    Util::EndCommand(computeCommand);
+
+    std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+    if (gTransferTicket > gComputeTransferWaitTicket)
     {
-        transferQueue = gTransferQueue;
-        transferCommand = gTransferCommand;
-        transferFence = gTransferFence;
+        waitInfos.emplace_back(vk::SemaphoreSubmitInfo()
+                                   .setSemaphore(gTransferTimeline)
+                                   .setValue(gTransferTicket)
+                                   .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+        gComputeTransferWaitTicket = gTransferTicket;
     }
-    Util::EndCommand(transferCommand);
-    Util::SubmitQueueHost(transferQueue, transferCommand, transferFence);
-    Util::WaitFence(gContext, transferFence);
-    Util::ResetFence(gContext, transferFence);
-    for (const auto& buffer : gTransferStagingBuffers)
+    if (gComputeGraphicsWaitValue > 0)
     {
-        buffer.Destroy(gContext);
+        waitInfos.emplace_back(vk::SemaphoreSubmitInfo()
+                                   .setSemaphore(gGraphicsTimeline)
+                                   .setValue(gComputeGraphicsWaitValue)
+                                   .setStageMask(vk::PipelineStageFlagBits2::eAllCommands));
+        gComputeGraphicsWaitValue = 0;
+    }
+    const auto ticket = ++gComputeTicket;
+    const auto signalInfo = vk::SemaphoreSubmitInfo()
+                                .setSemaphore(gComputeTimeline)
+                                .setValue(ticket)
+                                .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+    Util::SubmitQueue(gComputeQueue, computeCommand.commandBuffer, waitInfos, signalInfo, nullptr);
+    gComputeCommandTickets[gComputeCommandIndex] = ticket;
+    gComputeCommandIndex = (gComputeCommandIndex + 1) % gComputeCommands.size();
+
+    // The matching acquires go into a graphics command buffer whose submit waits on this ticket
+    gPendingBufferAcquireBarriers.insert(
+        gPendingBufferAcquireBarriers.end(),
+        gComputeReleaseBarriers.begin(),
+        gComputeReleaseBarriers.end());
+    gComputeReleaseBarriers.clear();
+    if (gRecordingFrame)
+    {
+        RecordPendingAcquires(Render::GetCommandBuffer(gCurrentFrameData));
     }
-    gTransferStagingBuffers.clear();
+    return ticket;
+}
+
+bool Swift::IsComputeComplete(const ComputeTicket ticket)
+{
+    return Util::GetSemaphoreValue(gContext, gComputeTimeline) >= ticket;
+}
+
+void Swift::WaitCompute(const ComputeTicket ticket)
+{
+    Util::WaitSemaphore(gContext, gComputeTimeline, ticket);
+}
+
+void Swift::ReleaseToCompute(const BufferHandle bufferHandle)
+{
+    assert(gRecordingFrame && !tRecording && "ReleaseToCompute must be recorded into the frame");
+    const auto& realBuffer = gBuffers.Get(bufferHandle);
+    const auto barrier = OwnershipBarrier(realBuffer, gGraphicsQueue.index, gComputeQueue.index);
+    Util::PipelineBarrier(gContext, Render::GetCommandBuffer(gCurrentFrameData), barrier);
+    gPendingComputeAcquires.emplace_back(GetPendingGraphicsValue(), barrier);
+}
+
+void Swift::ReleaseToGraphics(const BufferHandle bufferHandle)
+{
+    assert(tRecording == &gComputeRecording && "ReleaseToGraphics called outside BeginCompute");
+    const auto& realBuffer = gBuffers.Get(bufferHandle);
+    const auto barrier = OwnershipBarrier(realBuffer, gComputeQueue.index, gGraphicsQueue.index);
+    Util::PipelineBarrier(gContext, gComputeRecording.commandBuffer, barrier);
+    gComputeReleaseBarriers.emplace_back(barrier);
 }
 
 ThreadHandle Swift::CreateGraphicsThreadContext()
@@ -1014,9 +2549,18 @@ ThreadHandle Swift::CreateGraphicsThreadContext()
         Init::CreateCommandBuffer(gContext, commandPool, "Thread Command Buffer");
     const auto command = Command().SetCommandBuffer(commandBuffer).SetCommandPool(commandPool);
 
-    const auto fence = Init::CreateFence(gContext, {}, "Thread Fence");
-
-    gThreadDatas.emplace_back(Thread().SetQueue(threadQueue).SetCommand(command).SetFence(fence));
+    const auto timeline = Init::CreateTimelineSemaphore(gContext, 0, "Thread Timeline");
+    const auto stagingRing = Init::CreateStagingRing(
+        gContext,
+        gGraphicsQueue.index,
+        gInitInfo.stagingBufferSize,
+        "Thread Staging Ring");
+
+    gThreadDatas.emplace_back(Thread()
+                                  .SetQueue(threadQueue)
+                                  .SetCommand(command)
+                                  .SetTimeline(timeline)
+                                  .SetStagingRing(stagingRing));
 
     return size;
 }
@@ -0,0 +1,476 @@
+#include "SwiftBVH.hpp"
+
+namespace
+{
+    constexpr u32 BinCount = 12;
+    // Ranges this small stay leaves, larger ones only when no split is cheaper than testing all
+    constexpr u32 MinLeafSize = 2;
+    constexpr u32 MaxLeafSize = 8;
+    constexpr u32 AllPlanesMask = (1u << 6) - 1;
+
+    struct Box
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        void Grow(const glm::vec3 point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+        void Grow(const Box& box)
+        {
+            min = glm::min(min, box.min);
+            max = glm::max(max, box.max);
+        }
+        float GetHalfArea() const
+        {
+            const auto size = max - min;
+            return size.x >= 0.0f ? size.x * size.y + size.y * size.z + size.z * size.x : 0.0f;
+        }
+    };
+
+    Box GetSphereBox(const glm::vec4& sphere)
+    {
+        const auto center = glm::vec3(sphere);
+        return Box{center - sphere.w, center + sphere.w};
+    }
+
+    std::array<const Swift::Plane*, 6> GetPlanes(const Swift::Frustum& frustum)
+    {
+        return {
+            &frustum.leftFace,
+            &frustum.rightFace,
+            &frustum.topFace,
+            &frustum.bottomFace,
+            &frustum.nearFace,
+            &frustum.farFace};
+    }
+
+    // Distance along the ray at which it enters the box, infinity when it misses
+    float IntersectBox(
+        const glm::vec3 origin,
+        const glm::vec3 inverseDirection,
+        const glm::vec3 min,
+        const glm::vec3 max,
+        const float maxDistance)
+    {
+        const auto t0 = (min - origin) * inverseDirection;
+        const auto t1 = (max - origin) * inverseDirection;
+        const auto tNear = glm::min(t0, t1);
+        const auto tFar = glm::max(t0, t1);
+        const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+    }
+} // namespace
+
+namespace Swift
+{
+    void BVH::Build(const BoundsSoA& bounds)
+    {
+        const auto count = bounds.GetCount();
+        nodes.clear();
+        spheres.resize(count);
+        objectIndices.resize(count);
+        objectLeaves.resize(count);
+        if (count == 0)
+        {
+            return;
+        }
+
+        for (u32 i = 0; i < count; i++)
+        {
+            UpdateSphere(bounds, i);
+            objectIndices[i] = i;
+        }
+
+        // A binary tree over count leaves has at most 2 * count - 1 nodes, so this never grows
+        nodes.reserve(2 * count - 1);
+        auto& root = nodes.emplace_back();
+        root.first = 0;
+        root.count = count;
+        FitNode(root);
+
+        std::vector<u32> stack{0};
+        while (!stack.empty())
+        {
+            const auto nodeIndex = stack.back();
+            stack.pop_back();
+            Split(nodeIndex);
+            const auto& node = nodes[nodeIndex];
+            if (node.left != 0)
+            {
+                stack.emplace_back(node.left);
+                stack.emplace_back(node.left + 1);
+                continue;
+            }
+            for (u32 i = node.first; i < node.first + node.count; i++)
+            {
+                objectLeaves[objectIndices[i]] = nodeIndex;
+            }
+        }
+    }
+
+    void BVH::Refit(
+        const BoundsSoA& bounds,
+        const std::span<const u32> changedIndices)
+    {
+        for (const auto index : changedIndices)
+        {
+            UpdateSphere(bounds, index);
+        }
+        for (const auto index : changedIndices)
+        {
+            // Once a box stays the same the ones above it already account for every change below
+            auto nodeIndex = objectLeaves[index];
+            while (true)
+            {
+                auto& node = nodes[nodeIndex];
+                const auto oldMin = node.min;
+                const auto oldMax = node.max;
+                FitNode(node);
+                if (nodeIndex == 0 || (node.min == oldMin && node.max == oldMax))
+                {
+                    break;
+                }
+                nodeIndex = node.parent;
+            }
+        }
+    }
+
+    void BVH::Refit(const BoundsSoA& bounds)
+    {
+        for (u32 i = 0; i < spheres.size(); i++)
+        {
+            UpdateSphere(bounds, i);
+        }
+        // Children are always created after their parent, so walking backwards fits them first
+        for (auto node = nodes.rbegin(); node != nodes.rend(); ++node)
+        {
+            FitNode(*node);
+        }
+    }
+
+    u32 BVH::QueryFrustum(
+        const Frustum& frustum,
+        const std::span<u32> visibleIndices) const
+    {
+        if (nodes.empty())
+        {
+            return 0;
+        }
+
+        const auto planes = GetPlanes(frustum);
+        u32 visibleCount = 0;
+        // Node index and the planes its box is not yet known to be inside of
+        std::vector<std::pair<u32, u32>> stack{{0, AllPlanesMask}};
+        while (!stack.empty())
+        {
+            auto [nodeIndex, planeMask] = stack.back();
+            stack.pop_back();
+            const auto& node = nodes[nodeIndex];
+
+            const auto center = (node.min + node.max) * 0.5f;
+            const auto extents = (node.max - node.min) * 0.5f;
+            bool bOutside = false;
+            for (u32 i = 0; i < planes.size() && !bOutside; i++)
+            {
+                if ((planeMask & 1u << i) == 0)
+                {
+                    continue;
+                }
+                const auto& plane = *planes[i];
+                const float distance = glm::dot(plane.normal, center) - plane.distance;
+                const float radius = glm::dot(glm::abs(plane.normal), extents);
+                bOutside = distance <= -radius;
+                if (distance > radius)
+                {
+                    planeMask &= ~(1u << i);
+                }
+            }
+            if (bOutside)
+            {
+                continue;
+            }
+
+            const auto objects = std::span(objectIndices).subspan(node.first, node.count);
+            if (planeMask == 0)
+            {
+                std::ranges::copy(objects, visibleIndices.begin() + visibleCount);
+                visibleCount += node.count;
+                continue;
+            }
+            if (node.left != 0)
+            {
+                stack.emplace_back(node.left, planeMask);
+                stack.emplace_back(node.left + 1, planeMask);
+                continue;
+            }
+
+            // Same test as Visibility::IsInFrustum, so both agree on what is visible
+            for (const auto index : objects)
+            {
+                const auto& sphere = spheres[index];
+                bool bVisible = true;
+                for (u32 i = 0; i < planes.size() && bVisible; i++)
+                {
+                    const auto& plane = *planes[i];
+                    bVisible = (planeMask & 1u << i) == 0 ||
+                               glm::dot(plane.normal, glm::vec3(sphere)) - plane.distance >
+                                   -sphere.w;
+                }
+                if (bVisible)
+                {
+                    visibleIndices[visibleCount++] = index;
+                }
+            }
+        }
+        return visibleCount;
+    }
+
+    std::optional<RayHit> BVH::Raycast(
+        const glm::vec3 origin,
+        const glm::vec3 direction,
+        const float maxDistance) const
+    {
+        if (nodes.empty())
+        {
+            return std::nullopt;
+        }
+
+        const auto inverseDirection = 1.0f / direction;
+        RayHit closest{InvalidHandle, maxDistance};
+        std::vector<std::pair<u32, float>> stack;
+        if (const auto entry = IntersectBox(
+                origin,
+                inverseDirection,
+                nodes[0].min,
+                nodes[0].max,
+                maxDistance);
+            entry != std::numeric_limits<float>::infinity())
+        {
+            stack.emplace_back(0, entry);
+        }
+        while (!stack.empty())
+        {
+            const auto [nodeIndex, entry] = stack.back();
+            stack.pop_back();
+            // A closer hit may have been found since the node was pushed
+            if (entry > closest.distance)
+            {
+                continue;
+            }
+
+            const auto& node = nodes[nodeIndex];
+            if (node.left != 0)
+            {
+                std::array<std::pair<u32, float>, 2> children;
+                for (u32 i = 0; i < 2; i++)
+                {
+                    const auto& child = nodes[node.left + i];
+                    children[i] = {
+                        node.left + i,
+                        IntersectBox(
+                            origin,
+                            inverseDirection,
+                            child.min,
+                            child.max,
+                            closest.distance)};
+                }
+                // The nearer child is pushed last so it is searched first
+                if (children[0].second < children[1].second)
+                {
+                    std::swap(children[0], children[1]);
+                }
+                for (const auto& child : children)
+                {
+                    if (child.second != std::numeric_limits<float>::infinity())
+                    {
+                        stack.emplace_back(child);
+                    }
+                }
+                continue;
+            }
+
+            for (u32 i = node.first; i < node.first + node.count; i++)
+            {
+                const auto index = objectIndices[i];
+                const auto& sphere = spheres[index];
+                const auto offset = origin - glm::vec3(sphere);
+                const float b = glm::dot(offset, direction);
+                const float c = glm::dot(offset, offset) - sphere.w * sphere.w;
+                const float discriminant = b * b - c;
+                if (discriminant < 0.0f)
+                {
+                    continue;
+                }
+                // Spheres around the origin count where the ray leaves them, otherwise a large
+                // object surrounding the camera would hide everything inside it
+                const float root = std::sqrt(discriminant);
+                const float distance = -b - root >= 0.0f ? -b - root : -b + root;
+                if (distance >= 0.0f && distance < closest.distance)
+                {
+                    closest = {index, distance};
+                }
+            }
+        }
+
+        if (closest.index == InvalidHandle)
+        {
+            return std::nullopt;
+        }
+        return closest;
+    }
+
+    void BVH::UpdateSphere(
+        const BoundsSoA& bounds,
+        const u32 index)
+    {
+        const auto& transform = bounds.transform;
+        const auto getColumn = [&](const u32 column)
+        {
+            return glm::vec3(
+                transform[column * 3 + 0][index],
+                transform[column * 3 + 1][index],
+                transform[column * 3 + 2][index]);
+        };
+        const glm::vec3 center{bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index]};
+        const auto worldCenter = getColumn(0) * center.x + getColumn(1) * center.y +
+                                 getColumn(2) * center.z + getColumn(3);
+        const float maxScale = std::max(
+            std::max(glm::length(getColumn(0)), glm::length(getColumn(1))),
+            glm::length(getColumn(2)));
+        spheres[index] = glm::vec4(worldCenter, bounds.radius[index] * maxScale);
+    }
+
+    void BVH::FitNode(Node& node) const
+    {
+        Box box;
+        if (node.left != 0)
+        {
+            box.Grow(Box{nodes[node.left].min, nodes[node.left].max});
+            box.Grow(Box{nodes[node.left + 1].min, nodes[node.left + 1].max});
+        }
+        else
+        {
+            for (u32 i = node.first; i < node.first + node.count; i++)
+            {
+                box.Grow(GetSphereBox(spheres[objectIndices[i]]));
+            }
+        }
+        node.min = box.min;
+        node.max = box.max;
+    }
+
+    void BVH::Split(const u32 nodeIndex)
+    {
+        const auto first = nodes[nodeIndex].first;
+        const auto count = nodes[nodeIndex].count;
+        if (count <= MinLeafSize)
+        {
+            return;
+        }
+
+        const auto objects = std::span(objectIndices).subspan(first, count);
+        Box centroidBox;
+        for (const auto index : objects)
+        {
+            centroidBox.Grow(glm::vec3(spheres[index]));
+        }
+
+        // Binned surface area heuristic, trying every axis the centroids spread along
+        struct Bin
+        {
+            Box box;
+            u32 count = 0;
+        };
+        float bestCost = std::numeric_limits<float>::max();
+        u32 bestAxis = 0;
+        u32 bestSplit = 0;
+        const auto centroidSize = centroidBox.max - centroidBox.min;
+        const auto getBin = [&](const u32 axis, const u32 index)
+        {
+            const float position = spheres[index][axis] - centroidBox.min[axis];
+            const auto bin = static_cast<u32>(position / centroidSize[axis] * BinCount);
+            return std::min(bin, BinCount - 1);
+        };
+        for (u32 axis = 0; axis < 3; axis++)
+        {
+            if (centroidSize[axis] <= 0.0f)
+            {
+                continue;
+            }
+            std::array<Bin, BinCount> bins{};
+            for (const auto index : objects)
+            {
+                auto& bin = bins[getBin(axis, index)];
+                bin.box.Grow(GetSphereBox(spheres[index]));
+                bin.count++;
+            }
+
+            // Cost of everything right of each split, then swept against the left side
+            std::array<float, BinCount> rightCosts{};
+            Box rightBox;
+            u32 rightCount = 0;
+            for (u32 split = BinCount - 1; split > 0; split--)
+            {
+                rightBox.Grow(bins[split].box);
+                rightCount += bins[split].count;
+                rightCosts[split] = rightBox.GetHalfArea() * static_cast<float>(rightCount);
+            }
+            Box leftBox;
+            u32 leftCount = 0;
+            for (u32 split = 1; split < BinCount; split++)
+            {
+                leftBox.Grow(bins[split - 1].box);
+                leftCount += bins[split - 1].count;
+                const float cost =
+                    leftBox.GetHalfArea() * static_cast<float>(leftCount) + rightCosts[split];
+                if (leftCount > 0 && leftCount < count && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        const auto& node = nodes[nodeIndex];
+        const float leafCost = Box{node.min, node.max}.GetHalfArea() * static_cast<float>(count);
+        if (count <= MaxLeafSize && (bestSplit == 0 || bestCost >= leafCost))
+        {
+            return;
+        }
+
+        u32 leftCount;
+        if (bestSplit != 0)
+        {
+            const auto middle = std::partition(
+                objects.begin(),
+                objects.end(),
+                [&](const u32 index)
+                {
+                    return getBin(bestAxis, index) < bestSplit;
+                });
+            leftCount = static_cast<u32>(middle - objects.begin());
+        }
+        else
+        {
+            // Every centroid is in the same place, so any split is as good as another
+            leftCount = count / 2;
+        }
+
+        const auto left = static_cast<u32>(nodes.size());
+        nodes[nodeIndex].left = left;
+        for (const auto& [childFirst, childCount] :
+             {std::pair{first, leftCount}, std::pair{first + leftCount, count - leftCount}})
+        {
+            auto& child = nodes.emplace_back();
+            child.first = childFirst;
+            child.count = childCount;
+            child.parent = nodeIndex;
+            FitNode(child);
+        }
+    }
+} // namespace Swift
@@ -0,0 +1,127 @@
+#include "SwiftOcclusion.hpp"
+#include "Swift.hpp"
+#include "bit"
+
+namespace
+{
+    using namespace Swift;
+
+    struct PyramidHeader
+    {
+        u32 mipCount{};
+        u32 padding[3]{};
+        // Width, height and offset into the texels, the last component is unused
+        glm::uvec4 mips[Occlusion::MaxPyramidMips]{};
+    };
+
+    struct ReducePushConstant
+    {
+        u64 srcBuffer{};
+        u64 dstBuffer{};
+        glm::uvec2 srcSize{};
+        glm::uvec2 dstSize{};
+    };
+
+    OcclusionInfo gOcclusionInfo;
+    BufferHandle gDepthBuffer = InvalidHandle;
+    BufferHandle gPyramidBuffer = InvalidHandle;
+    PyramidHeader gPyramidHeader;
+    glm::uvec2 gDepthExtent{};
+
+    void DestroyBuffers()
+    {
+        if (IsValid(gDepthBuffer))
+        {
+            DestroyBuffer(gDepthBuffer);
+            gDepthBuffer = InvalidHandle;
+        }
+        if (IsValid(gPyramidBuffer))
+        {
+            DestroyBuffer(gPyramidBuffer);
+            gPyramidBuffer = InvalidHandle;
+        }
+    }
+
+    void CreateBuffers(const glm::uvec2 extent)
+    {
+        DestroyBuffers();
+        gDepthExtent = extent;
+        const auto depthSize = static_cast<u32>(extent.x * extent.y * sizeof(float));
+        gDepthBuffer = CreateBuffer(BufferType::eStorage, depthSize, "Depth Copy Buffer");
+
+        gPyramidHeader = {};
+        glm::uvec2 mipSize(std::bit_floor(extent.x), std::bit_floor(extent.y));
+        u32 texelCount = 0;
+        while (gPyramidHeader.mipCount < Occlusion::MaxPyramidMips)
+        {
+            gPyramidHeader.mips[gPyramidHeader.mipCount++] =
+                glm::uvec4(mipSize.x, mipSize.y, texelCount, 0);
+            // Keeps every mip 16 byte aligned for the shaders addressing it directly
+            texelCount += (mipSize.x * mipSize.y + 3) & ~3u;
+            if (mipSize == glm::uvec2(1))
+            {
+                break;
+            }
+            mipSize = glm::max(mipSize / 2u, glm::uvec2(1));
+        }
+
+        const auto pyramidSize =
+            static_cast<u32>(sizeof(PyramidHeader) + texelCount * sizeof(float));
+        gPyramidBuffer = CreateBuffer(BufferType::eStorage, pyramidSize, "Depth Pyramid Buffer");
+        UploadToBuffer(gPyramidBuffer, &gPyramidHeader, 0, sizeof(PyramidHeader));
+    }
+} // namespace
+
+void Swift::Occlusion::Init(const OcclusionInfo& occlusionInfo)
+{
+    assert(IsValid(occlusionInfo.reduceShader) && "Occlusion culling needs a reduce shader");
+    gOcclusionInfo = occlusionInfo;
+    CreateBuffers(GetSwapchainExtent());
+}
+
+void Swift::Occlusion::Shutdown()
+{
+    DestroyBuffers();
+    gDepthExtent = {};
+}
+
+void Swift::Occlusion::BuildDepthPyramid()
+{
+    const auto extent = GetSwapchainExtent();
+    if (extent != gDepthExtent)
+    {
+        CreateBuffers(extent);
+    }
+
+    CopyDepthToBuffer(gDepthBuffer);
+    BufferBarrier(gDepthBuffer);
+    BindShader(gOcclusionInfo.reduceShader);
+
+    const auto texelAddress = GetBufferAddress(gPyramidBuffer) + sizeof(PyramidHeader);
+    ReducePushConstant pushConstant{
+        .srcBuffer = GetBufferAddress(gDepthBuffer),
+        .srcSize = gDepthExtent,
+    };
+    for (u32 mip = 0; mip < gPyramidHeader.mipCount; mip++)
+    {
+        const auto& mipInfo = gPyramidHeader.mips[mip];
+        pushConstant.dstBuffer = texelAddress + mipInfo.z * sizeof(float);
+        pushConstant.dstSize = glm::uvec2(mipInfo.x, mipInfo.y);
+        PushConstant(pushConstant);
+        DispatchCompute((mipInfo.x + 7) / 8, (mipInfo.y + 7) / 8, 1);
+        BufferBarrier(gPyramidBuffer);
+
+        pushConstant.srcBuffer = pushConstant.dstBuffer;
+        pushConstant.srcSize = pushConstant.dstSize;
+    }
+}
+
+u64 Swift::Occlusion::GetDepthPyramidAddress()
+{
+    return GetBufferAddress(gPyramidBuffer);
+}
+
+glm::uvec2 Swift::Occlusion::GetDepthPyramidSize()
+{
+    return {gPyramidHeader.mips[0].x, gPyramidHeader.mips[0].y};
+}
@@ -0,0 +1,345 @@
+#include "SwiftStreaming.hpp"
+#include "Swift.hpp"
+
+namespace
+{
+    using namespace Swift;
+
+    struct StreamedImage
+    {
+        ImageHandle image = InvalidHandle;
+        std::vector<u32> lodIndices;
+        // Coarsest mip a load may start at, the finest is always 0
+        int coarsestMip{};
+        int residentMip{};
+        int desiredMip{};
+        u64 memorySize{};
+        bool bLoading{};
+        // The file went missing or stopped parsing after registration, so it stays as it is
+        bool bFailed{};
+    };
+
+    struct PendingLoad
+    {
+        ImageHandle image = InvalidHandle;
+        // Stays invalid for in place loads
+        ImageHandle tempImage = InvalidHandle;
+        TransferTicket ticket{};
+        int mip{};
+    };
+
+    StreamingInfo gStreamingInfo;
+    BufferHandle gLodBuffer = InvalidHandle;
+    // One readback buffer per frame slot, read once the slot's fence has been waited on again
+    std::vector<BufferHandle> gReadbackBuffers;
+    std::vector<bool> gReadbackRecorded;
+    std::vector<float> gLods;
+    std::unordered_map<ImageHandle, StreamedImage> gStreamedImages;
+    std::vector<PendingLoad> gPendingLoads;
+    u64 gResidentMemory = 0;
+
+    // Mip chains shrink by about a factor of four per level
+    u64 EstimateMemorySize(
+        const u64 memorySize,
+        const int fromMip,
+        const int toMip)
+    {
+        if (toMip < fromMip)
+        {
+            return memorySize << (2 * (fromMip - toMip));
+        }
+        return memorySize >> (2 * (toMip - fromMip));
+    }
+
+    void FinishLoads()
+    {
+        std::erase_if(
+            gPendingLoads,
+            [](const PendingLoad& load)
+            {
+                if (!IsTransferComplete(load.ticket))
+                {
+                    return false;
+                }
+                const auto it = gStreamedImages.find(load.image);
+                if (it == gStreamedImages.end())
+                {
+                    // Unregistered while loading
+                    if (IsValid(load.tempImage))
+                    {
+                        DestroyImage(load.tempImage);
+                    }
+                    return true;
+                }
+                auto& streamedImage = it->second;
+                streamedImage.residentMip = load.mip;
+                streamedImage.bLoading = false;
+                if (!IsValid(load.tempImage))
+                {
+                    SetImageMinLod(load.image, load.mip);
+                    return true;
+                }
+                UpdateImage(load.image, load.tempImage);
+                gResidentMemory -= streamedImage.memorySize;
+                streamedImage.memorySize = GetImageMemorySize(load.image);
+                gResidentMemory += streamedImage.memorySize;
+                return true;
+            });
+    }
+
+    void UpdateDesiredMips()
+    {
+        for (auto& [handle, streamedImage] : gStreamedImages)
+        {
+            auto lod = std::numeric_limits<float>::max();
+            for (const auto index : streamedImage.lodIndices)
+            {
+                lod = std::min(lod, gLods[index]);
+            }
+            const auto mip = static_cast<int>(lod) + gStreamingInfo.mipBias;
+            streamedImage.desiredMip = std::clamp(mip, 0, streamedImage.coarsestMip);
+        }
+    }
+
+    void QueueLoads()
+    {
+        std::vector<StreamedImage*> requests;
+        for (auto& [handle, streamedImage] : gStreamedImages)
+        {
+            if (streamedImage.bLoading || streamedImage.bFailed ||
+                streamedImage.desiredMip == streamedImage.residentMip)
+            {
+                continue;
+            }
+            // Mips refined in place stay allocated, so there is nothing to gain from dropping them
+            if (!gStreamingInfo.bInPlaceMips || streamedImage.desiredMip < streamedImage.residentMip)
+            {
+                requests.emplace_back(&streamedImage);
+            }
+        }
+        if (requests.empty())
+        {
+            return;
+        }
+
+        // Drops go first since they free memory for the upgrades, which are then ordered by how
+        // far they are from the resolution they want
+        std::ranges::sort(
+            requests,
+            [](const StreamedImage* a, const StreamedImage* b)
+            {
+                const auto aDelta = a->residentMip - a->desiredMip;
+                const auto bDelta = b->residentMip - b->desiredMip;
+                if ((aDelta < 0) != (bDelta < 0))
+                {
+                    return aDelta < 0;
+                }
+                return aDelta > bDelta;
+            });
+
+        auto projectedMemory = gResidentMemory;
+        for (const auto& load : gPendingLoads)
+        {
+            const auto it = gStreamedImages.find(load.image);
+            if (!IsValid(load.tempImage) || it == gStreamedImages.end())
+            {
+                continue;
+            }
+            const auto& streamedImage = it->second;
+            projectedMemory +=
+                EstimateMemorySize(streamedImage.memorySize, streamedImage.residentMip, load.mip);
+            projectedMemory -= streamedImage.memorySize;
+        }
+
+        u32 loadCount = 0;
+        bool bTransferOpen = false;
+        for (auto* streamedImage : requests)
+        {
+            if (loadCount == gStreamingInfo.maxLoadsPerFrame)
+            {
+                break;
+            }
+            if (gStreamingInfo.bInPlaceMips)
+            {
+                if (!bTransferOpen)
+                {
+                    BeginTransfer();
+                    bTransferOpen = true;
+                }
+                // Progressive refinement, each load adds the next finer mip
+                const auto mip = streamedImage->residentMip - 1;
+                if (!LoadImageMipQueued(streamedImage->image, mip))
+                {
+                    streamedImage->bFailed = true;
+                    continue;
+                }
+                gPendingLoads.emplace_back(streamedImage->image, InvalidHandle, 0, mip);
+                streamedImage->bLoading = true;
+                loadCount++;
+                continue;
+            }
+
+            const auto mip = streamedImage->desiredMip;
+            const auto newSize =
+                EstimateMemorySize(streamedImage->memorySize, streamedImage->residentMip, mip);
+            if (newSize > streamedImage->memorySize &&
+                projectedMemory - streamedImage->memorySize + newSize > gStreamingInfo.memoryBudget)
+            {
+                continue;
+            }
+            projectedMemory = projectedMemory - streamedImage->memorySize + newSize;
+
+            if (!bTransferOpen)
+            {
+                BeginTransfer();
+                bTransferOpen = true;
+            }
+            const auto tempImage = LoadImageFromFileQueued(
+                GetURI(streamedImage->image),
+                mip,
+                true,
+                GetURI(streamedImage->image),
+                true);
+            if (!IsValid(tempImage))
+            {
+                streamedImage->bFailed = true;
+                continue;
+            }
+            gPendingLoads.emplace_back(streamedImage->image, tempImage, 0, mip);
+            streamedImage->bLoading = true;
+            loadCount++;
+        }
+        if (!bTransferOpen)
+        {
+            return;
+        }
+
+        const auto ticket = EndTransfer();
+        for (auto& load : gPendingLoads | std::views::reverse | std::views::take(loadCount))
+        {
+            load.ticket = ticket;
+        }
+    }
+} // namespace
+
+void Swift::Streaming::Init(const StreamingInfo& streamingInfo)
+{
+    assert(streamingInfo.lodCount > 0 && "Streaming needs at least one LOD entry");
+    gStreamingInfo = streamingInfo;
+    const auto lodSize = static_cast<u32>(streamingInfo.lodCount * sizeof(float));
+    // The LOD pass and its readback run in the frame or in a compute batch, so both are shared
+    gLodBuffer = CreateBuffer(BufferType::eStorage, lodSize, "Streaming LOD Buffer", true);
+
+    const auto frameCount = GetFramesInFlight();
+    gReadbackBuffers.resize(frameCount);
+    for (auto& readbackBuffer : gReadbackBuffers)
+    {
+        readbackBuffer =
+            CreateBuffer(BufferType::eReadback, lodSize, "Streaming Readback Buffer", true);
+    }
+    gReadbackRecorded.assign(frameCount, false);
+    gLods.assign(streamingInfo.lodCount, std::numeric_limits<float>::max());
+}
+
+void Swift::Streaming::Shutdown()
+{
+    for (const auto& load : gPendingLoads)
+    {
+        WaitTransfer(load.ticket);
+        if (IsValid(load.tempImage))
+        {
+            DestroyImage(load.tempImage);
+        }
+    }
+    gPendingLoads.clear();
+    gStreamedImages.clear();
+    gResidentMemory = 0;
+
+    for (const auto readbackBuffer : gReadbackBuffers)
+    {
+        DestroyBuffer(readbackBuffer);
+    }
+    gReadbackBuffers.clear();
+    gReadbackRecorded.clear();
+    DestroyBuffer(gLodBuffer);
+    gLodBuffer = InvalidHandle;
+}
+
+void Swift::Streaming::RegisterImage(
+    const ImageHandle image,
+    const std::span<const u32> lodIndices)
+{
+    // Streamed images always keep the chain down to 4x4, so the full width follows from the
+    // size of the finest resident mip. Progressive images are allocated at full size.
+    const auto residentMip = GetMinLod(image);
+    auto fullWidth = GetImageSize(image).x;
+    if (!gStreamingInfo.bInPlaceMips)
+    {
+        fullWidth <<= residentMip;
+    }
+    const auto smallestMip = static_cast<int>(std::log2(std::max(fullWidth / 4, 1u)));
+
+    StreamedImage streamedImage;
+    streamedImage.image = image;
+    streamedImage.lodIndices.assign(lodIndices.begin(), lodIndices.end());
+    streamedImage.coarsestMip = std::max(std::min(GetMaxLod(image), smallestMip), 0);
+    streamedImage.residentMip = residentMip;
+    streamedImage.desiredMip = residentMip;
+    streamedImage.memorySize = GetImageMemorySize(image);
+
+    [[maybe_unused]]
+    const auto [it, inserted] = gStreamedImages.try_emplace(image, std::move(streamedImage));
+    assert(inserted && "Image is already registered for streaming");
+    gResidentMemory += it->second.memorySize;
+}
+
+void Swift::Streaming::UnregisterImage(const ImageHandle image)
+{
+    const auto it = gStreamedImages.find(image);
+    if (it == gStreamedImages.end())
+    {
+        return;
+    }
+    gResidentMemory -= it->second.memorySize;
+    gStreamedImages.erase(it);
+}
+
+u64 Swift::Streaming::GetLodBufferAddress()
+{
+    return GetBufferAddress(gLodBuffer);
+}
+
+void Swift::Streaming::RecordReadback()
+{
+    const auto frameIndex = GetFrameIndex();
+    BufferBarrier(gLodBuffer);
+    CopyBuffer(gLodBuffer, gReadbackBuffers[frameIndex], 0, 0, gLods.size() * sizeof(float));
+    gReadbackRecorded[frameIndex] = true;
+}
+
+void Swift::Streaming::Update()
+{
+    FinishLoads();
+
+    // BeginFrame waited on this slot's fence, so the copy recorded the last time round is done
+    const auto frameIndex = GetFrameIndex();
+    if (!gReadbackRecorded[frameIndex])
+    {
+        return;
+    }
+    gReadbackRecorded[frameIndex] = false;
+    DownloadBuffer(gReadbackBuffers[frameIndex], gLods.data(), 0, gLods.size() * sizeof(float));
+
+    UpdateDesiredMips();
+    QueueLoads();
+}
+
+u64 Swift::Streaming::GetResidentMemory()
+{
+    return gResidentMemory;
+}
+
+u32 Swift::Streaming::GetPendingLoadCount()
+{
+    return static_cast<u32>(gPendingLoads.size());
+}
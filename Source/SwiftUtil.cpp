@@ -1,7 +1,20 @@
 #include "SwiftUtil.hpp"
 #include "SwiftStructs.hpp"
+#include "Utils/JobSystem.hpp"
+#include "bit"
 #include "glm/gtx/norm.hpp"
 
+#if defined(__AVX2__)
+#include "immintrin.h"
+#define SWIFT_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include "emmintrin.h"
+#define SWIFT_SIMD_SSE
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include "arm_neon.h"
+#define SWIFT_SIMD_NEON
+#endif
+
 namespace
 {
     Swift::Plane CreatePlane(
@@ -59,6 +72,172 @@ namespace
         return files;
     }
 
+    // Lane wise operations the batched culling is written against, one set per instruction set.
+    // Masks come out of MoveMask with one bit per lane.
+    struct ScalarLanes
+    {
+        using Float = float;
+        using Mask = bool;
+        static constexpr u32 Width = 1;
+
+        static Float Load(const float* data) { return *data; }
+        static Float Set(const float value) { return value; }
+        static Float Add(const Float a, const Float b) { return a + b; }
+        static Float Mul(const Float a, const Float b) { return a * b; }
+        static Float Max(const Float a, const Float b) { return std::max(a, b); }
+        static Float Sqrt(const Float a) { return std::sqrt(a); }
+        static Mask Greater(const Float a, const Float b) { return a > b; }
+        static Mask And(const Mask a, const Mask b) { return a && b; }
+        static u32 MoveMask(const Mask mask) { return mask ? 1 : 0; }
+    };
+
+#if defined(SWIFT_SIMD_AVX2)
+    struct SimdLanes
+    {
+        using Float = __m256;
+        using Mask = __m256;
+        static constexpr u32 Width = 8;
+
+        static Float Load(const float* data) { return _mm256_loadu_ps(data); }
+        static Float Set(const float value) { return _mm256_set1_ps(value); }
+        static Float Add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+        static Float Mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+        static Float Max(const Float a, const Float b) { return _mm256_max_ps(a, b); }
+        static Float Sqrt(const Float a) { return _mm256_sqrt_ps(a); }
+        static Mask Greater(const Float a, const Float b)
+        {
+            return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+        }
+        static Mask And(const Mask a, const Mask b) { return _mm256_and_ps(a, b); }
+        static u32 MoveMask(const Mask mask) { return _mm256_movemask_ps(mask); }
+    };
+#elif defined(SWIFT_SIMD_SSE)
+    struct SimdLanes
+    {
+        using Float = __m128;
+        using Mask = __m128;
+        static constexpr u32 Width = 4;
+
+        static Float Load(const float* data) { return _mm_loadu_ps(data); }
+        static Float Set(const float value) { return _mm_set1_ps(value); }
+        static Float Add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+        static Float Mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+        static Float Max(const Float a, const Float b) { return _mm_max_ps(a, b); }
+        static Float Sqrt(const Float a) { return _mm_sqrt_ps(a); }
+        static Mask Greater(const Float a, const Float b) { return _mm_cmpgt_ps(a, b); }
+        static Mask And(const Mask a, const Mask b) { return _mm_and_ps(a, b); }
+        static u32 MoveMask(const Mask mask) { return _mm_movemask_ps(mask); }
+    };
+#elif defined(SWIFT_SIMD_NEON)
+    struct SimdLanes
+    {
+        using Float = float32x4_t;
+        using Mask = uint32x4_t;
+        static constexpr u32 Width = 4;
+
+        static Float Load(const float* data) { return vld1q_f32(data); }
+        static Float Set(const float value) { return vdupq_n_f32(value); }
+        static Float Add(const Float a, const Float b) { return vaddq_f32(a, b); }
+        static Float Mul(const Float a, const Float b) { return vmulq_f32(a, b); }
+        static Float Max(const Float a, const Float b) { return vmaxq_f32(a, b); }
+        static Float Sqrt(const Float a) { return vsqrtq_f32(a); }
+        static Mask Greater(const Float a, const Float b) { return vcgtq_f32(a, b); }
+        static Mask And(const Mask a, const Mask b) { return vandq_u32(a, b); }
+        static u32 MoveMask(const Mask mask)
+        {
+            // NEON has no movemask, so each lane keeps its own bit and the lanes are summed.
+            // The bits are loaded from memory since MSVC has no vector initializer lists
+            static constexpr u32 bits[4] = {1, 2, 4, 8};
+            return vaddvq_u32(vandq_u32(mask, vld1q_u32(bits)));
+        }
+    };
+#else
+    using SimdLanes = ScalarLanes;
+#endif
+
+    // Culls whole groups of Lanes::Width objects starting at first and returns where it stopped
+    template <typename Lanes>
+    u32 CullLanes(
+        const Swift::Frustum& frustum,
+        const Swift::BoundsSoA& bounds,
+        const u32 first,
+        const u32 last,
+        u32* visibleIndices,
+        u32& visibleCount)
+    {
+        using Float = typename Lanes::Float;
+        const std::array planes = {
+            &frustum.leftFace,
+            &frustum.rightFace,
+            &frustum.topFace,
+            &frustum.bottomFace,
+            &frustum.nearFace,
+            &frustum.farFace};
+        // Plain arrays, std::array drops the alignment attributes of the vector types
+        Float planeLanes[4 * planes.size()];
+        for (u32 plane = 0; plane < planes.size(); plane++)
+        {
+            planeLanes[plane * 4 + 0] = Lanes::Set(planes[plane]->normal.x);
+            planeLanes[plane * 4 + 1] = Lanes::Set(planes[plane]->normal.y);
+            planeLanes[plane * 4 + 2] = Lanes::Set(planes[plane]->normal.z);
+            planeLanes[plane * 4 + 3] = Lanes::Set(-planes[plane]->distance);
+        }
+        const auto& m = bounds.transform;
+
+        u32 index = first;
+        for (; index + Lanes::Width <= last; index += Lanes::Width)
+        {
+            const auto x = Lanes::Load(bounds.centerX.data() + index);
+            const auto y = Lanes::Load(bounds.centerY.data() + index);
+            const auto z = Lanes::Load(bounds.centerZ.data() + index);
+            Float center[3];
+            for (u32 row = 0; row < 3; row++)
+            {
+                const auto rowX = Lanes::Mul(Lanes::Load(m[row].data() + index), x);
+                const auto rowY = Lanes::Mul(Lanes::Load(m[3 + row].data() + index), y);
+                const auto rowZ = Lanes::Mul(Lanes::Load(m[6 + row].data() + index), z);
+                const auto translation = Lanes::Load(m[9 + row].data() + index);
+                center[row] = Lanes::Add(Lanes::Add(rowX, rowY), Lanes::Add(rowZ, translation));
+            }
+
+            // Largest axis scale, squared lengths are compared so only one root is taken
+            Float maxScale = Lanes::Set(0.f);
+            for (u32 column = 0; column < 3; column++)
+            {
+                const auto axisX = Lanes::Load(m[column * 3 + 0].data() + index);
+                const auto axisY = Lanes::Load(m[column * 3 + 1].data() + index);
+                const auto axisZ = Lanes::Load(m[column * 3 + 2].data() + index);
+                const auto lengthSquared = Lanes::Add(
+                    Lanes::Mul(axisX, axisX),
+                    Lanes::Add(Lanes::Mul(axisY, axisY), Lanes::Mul(axisZ, axisZ)));
+                maxScale = Lanes::Max(maxScale, lengthSquared);
+            }
+            const auto radius = Lanes::Load(bounds.radius.data() + index);
+            const auto negativeRadius =
+                Lanes::Mul(Lanes::Mul(radius, Lanes::Sqrt(maxScale)), Lanes::Set(-1.f));
+
+            const auto isInsidePlane = [&](const u32 plane)
+            {
+                const auto* lanes = &planeLanes[plane * 4];
+                const auto distance = Lanes::Add(
+                    Lanes::Add(Lanes::Mul(lanes[0], center[0]), Lanes::Mul(lanes[1], center[1])),
+                    Lanes::Add(Lanes::Mul(lanes[2], center[2]), lanes[3]));
+                return Lanes::Greater(distance, negativeRadius);
+            };
+            auto inside = isInsidePlane(0);
+            for (u32 plane = 1; plane < planes.size(); plane++)
+            {
+                inside = Lanes::And(inside, isInsidePlane(plane));
+            }
+
+            for (auto mask = Lanes::MoveMask(inside); mask != 0; mask &= mask - 1)
+            {
+                visibleIndices[visibleCount++] = index + std::countr_zero(mask);
+            }
+        }
+        return index;
+    }
+
     auto beginTime = std::chrono::high_resolution_clock::now();
     auto endTime = std::chrono::high_resolution_clock::now();
 } // namespace
@@ -151,6 +330,97 @@ namespace Swift
                IsInsidePlane(frustum.farFace, boundingSphere);
     }
     
+    u32 Visibility::CullBounds(
+        const Frustum& frustum,
+        const BoundsSoA& bounds,
+        const u32 first,
+        const u32 last,
+        const std::span<u32> visibleIndices)
+    {
+        assert(visibleIndices.size() >= last - first && "Visible index span is too small");
+        u32 visibleCount = 0;
+        const auto tail =
+            CullLanes<SimdLanes>(frustum, bounds, first, last, visibleIndices.data(), visibleCount);
+        CullLanes<ScalarLanes>(frustum, bounds, tail, last, visibleIndices.data(), visibleCount);
+        return visibleCount;
+    }
+
+    u32 Visibility::CullBounds(
+        const Frustum& frustum,
+        const BoundsSoA& bounds,
+        const std::span<u32> visibleIndices)
+    {
+        return CullBounds(frustum, bounds, 0, bounds.GetCount(), visibleIndices);
+    }
+
+    u32 Visibility::CullAndBuild(
+        JobSystem& jobSystem,
+        const Frustum& frustum,
+        const BoundsSoA& bounds,
+        const u32 grainSize,
+        const std::function<void(u32 firstSlot, std::span<const u32> indices)>& build)
+    {
+        assert(grainSize > 0 && "Ranges need at least one object");
+        const auto count = bounds.GetCount();
+        if (count == 0)
+        {
+            return 0;
+        }
+        const auto rangeCount = (count + grainSize - 1) / grainSize;
+        // Each range compacts into its own slice, the slices are merged by the slots handed out
+        std::vector<u32> indices(count);
+        std::vector<u32> visibleCounts(rangeCount);
+        std::vector<u32> firstSlots(rangeCount);
+        u32 totalVisible = 0;
+
+        JobCounter cullCounter;
+        JobCounter scanCounter;
+        JobCounter buildCounter;
+        const auto getRange = [&](const u32 range)
+        {
+            const auto first = range * grainSize;
+            return std::span(indices).subspan(first, std::min(grainSize, count - first));
+        };
+        for (u32 range = 0; range < rangeCount; range++)
+        {
+            jobSystem.Submit(
+                [&, range]
+                {
+                    const auto first = range * grainSize;
+                    const auto last = first + static_cast<u32>(getRange(range).size());
+                    visibleCounts[range] =
+                        CullBounds(frustum, bounds, first, last, getRange(range));
+                },
+                &cullCounter);
+        }
+        jobSystem.Submit(
+            [&]
+            {
+                for (u32 range = 0; range < rangeCount; range++)
+                {
+                    firstSlots[range] = totalVisible;
+                    totalVisible += visibleCounts[range];
+                }
+            },
+            &scanCounter,
+            &cullCounter);
+        for (u32 range = 0; range < rangeCount; range++)
+        {
+            jobSystem.Submit(
+                [&, range]
+                {
+                    if (visibleCounts[range] != 0)
+                    {
+                        build(firstSlots[range], getRange(range).first(visibleCounts[range]));
+                    }
+                },
+                &buildCounter,
+                &scanCounter);
+        }
+        jobSystem.Wait(buildCounter);
+        return totalVisible;
+    }
+
     void Performance::BeginTimer()
     {
         beginTime = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,359 @@
+#include "Utils/DDS.hpp"
+#include "bit"
+
+namespace
+{
+    constexpr u32 MakeFourCC(
+        const char a,
+        const char b,
+        const char c,
+        const char d)
+    {
+        return static_cast<u32>(a) | static_cast<u32>(b) << 8 | static_cast<u32>(c) << 16 |
+               static_cast<u32>(d) << 24;
+    }
+
+    constexpr u32 Magic = MakeFourCC('D', 'D', 'S', ' ');
+    constexpr u32 PixelFormatFourCC = 0x4;
+    constexpr u32 PixelFormatRGB = 0x40;
+    constexpr u32 FlagDepth = 0x800000;
+    constexpr u32 Caps2Cubemap = 0x200;
+    constexpr u32 Caps2Volume = 0x200000;
+    constexpr u32 MiscTextureCube = 0x4;
+    constexpr u32 Dimension3D = 4;
+    // Far beyond any device's image limits, and small enough that a mip chain's size cannot
+    // overflow 64 bits
+    constexpr u32 MaxDimension = 1u << 16;
+
+    struct PixelFormat
+    {
+        u32 size;
+        u32 flags;
+        u32 fourCC;
+        u32 rgbBitCount;
+        u32 rMask;
+        u32 gMask;
+        u32 bMask;
+        u32 aMask;
+    };
+
+    struct FileHeader
+    {
+        u32 size;
+        u32 flags;
+        u32 height;
+        u32 width;
+        u32 pitchOrLinearSize;
+        u32 depth;
+        u32 mipMapCount;
+        u32 reserved[11];
+        PixelFormat pixelFormat;
+        u32 caps;
+        u32 caps2;
+        u32 caps3;
+        u32 caps4;
+        u32 reserved2;
+    };
+    static_assert(sizeof(FileHeader) == 124);
+
+    struct FileHeaderDX10
+    {
+        u32 dxgiFormat;
+        u32 resourceDimension;
+        u32 miscFlag;
+        u32 arraySize;
+        u32 miscFlags2;
+    };
+    static_assert(sizeof(FileHeaderDX10) == 20);
+
+    vk::Format GetFormatFromDXGI(const u32 dxgiFormat)
+    {
+        switch (dxgiFormat)
+        {
+        case 2: return vk::Format::eR32G32B32A32Sfloat;
+        case 10: return vk::Format::eR16G16B16A16Sfloat;
+        case 11: return vk::Format::eR16G16B16A16Unorm;
+        case 16: return vk::Format::eR32G32Sfloat;
+        case 24: return vk::Format::eA2B10G10R10UnormPack32;
+        case 26: return vk::Format::eB10G11R11UfloatPack32;
+        case 28: return vk::Format::eR8G8B8A8Unorm;
+        case 29: return vk::Format::eR8G8B8A8Srgb;
+        case 34: return vk::Format::eR16G16Sfloat;
+        case 35: return vk::Format::eR16G16Unorm;
+        case 41: return vk::Format::eR32Sfloat;
+        case 49: return vk::Format::eR8G8Unorm;
+        case 54: return vk::Format::eR16Sfloat;
+        case 56: return vk::Format::eR16Unorm;
+        case 61: return vk::Format::eR8Unorm;
+        case 71: return vk::Format::eBc1RgbaUnormBlock;
+        case 72: return vk::Format::eBc1RgbaSrgbBlock;
+        case 74: return vk::Format::eBc2UnormBlock;
+        case 75: return vk::Format::eBc2SrgbBlock;
+        case 77: return vk::Format::eBc3UnormBlock;
+        case 78: return vk::Format::eBc3SrgbBlock;
+        case 80: return vk::Format::eBc4UnormBlock;
+        case 81: return vk::Format::eBc4SnormBlock;
+        case 83: return vk::Format::eBc5UnormBlock;
+        case 84: return vk::Format::eBc5SnormBlock;
+        case 87: return vk::Format::eB8G8R8A8Unorm;
+        case 91: return vk::Format::eB8G8R8A8Srgb;
+        case 95: return vk::Format::eBc6HUfloatBlock;
+        case 96: return vk::Format::eBc6HSfloatBlock;
+        case 98: return vk::Format::eBc7UnormBlock;
+        case 99: return vk::Format::eBc7SrgbBlock;
+        default: return vk::Format::eUndefined;
+        }
+    }
+
+    // Files written without the DX10 extension name their format with a four character code, a
+    // D3DFORMAT number, or channel masks
+    vk::Format GetLegacyFormat(const PixelFormat& pixelFormat)
+    {
+        if (pixelFormat.flags & PixelFormatFourCC)
+        {
+            switch (pixelFormat.fourCC)
+            {
+            case MakeFourCC('D', 'X', 'T', '1'): return vk::Format::eBc1RgbaUnormBlock;
+            case MakeFourCC('D', 'X', 'T', '2'):
+            case MakeFourCC('D', 'X', 'T', '3'): return vk::Format::eBc2UnormBlock;
+            case MakeFourCC('D', 'X', 'T', '4'):
+            case MakeFourCC('D', 'X', 'T', '5'): return vk::Format::eBc3UnormBlock;
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'): return vk::Format::eBc4UnormBlock;
+            case MakeFourCC('B', 'C', '4', 'S'): return vk::Format::eBc4SnormBlock;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): return vk::Format::eBc5UnormBlock;
+            case MakeFourCC('B', 'C', '5', 'S'): return vk::Format::eBc5SnormBlock;
+            case 36: return vk::Format::eR16G16B16A16Unorm;
+            case 111: return vk::Format::eR16Sfloat;
+            case 112: return vk::Format::eR16G16Sfloat;
+            case 113: return vk::Format::eR16G16B16A16Sfloat;
+            case 114: return vk::Format::eR32Sfloat;
+            case 115: return vk::Format::eR32G32Sfloat;
+            case 116: return vk::Format::eR32G32B32A32Sfloat;
+            default: return vk::Format::eUndefined;
+            }
+        }
+        if ((pixelFormat.flags & PixelFormatRGB) && pixelFormat.rgbBitCount == 32)
+        {
+            if (pixelFormat.rMask == 0x000000ff && pixelFormat.bMask == 0x00ff0000)
+            {
+                return vk::Format::eR8G8B8A8Unorm;
+            }
+            if (pixelFormat.rMask == 0x00ff0000 && pixelFormat.bMask == 0x000000ff)
+            {
+                return vk::Format::eB8G8R8A8Unorm;
+            }
+        }
+        return vk::Format::eUndefined;
+    }
+
+    // Bytes per 4x4 block for compressed formats, per texel otherwise. 0 for unsupported formats.
+    u32 GetBlockSize(const vk::Format format)
+    {
+        switch (format)
+        {
+        case vk::Format::eBc1RgbaUnormBlock:
+        case vk::Format::eBc1RgbaSrgbBlock:
+        case vk::Format::eBc4UnormBlock:
+        case vk::Format::eBc4SnormBlock:
+        case vk::Format::eR16G16B16A16Sfloat:
+        case vk::Format::eR16G16B16A16Unorm:
+        case vk::Format::eR32G32Sfloat: return 8;
+        case vk::Format::eBc2UnormBlock:
+        case vk::Format::eBc2SrgbBlock:
+        case vk::Format::eBc3UnormBlock:
+        case vk::Format::eBc3SrgbBlock:
+        case vk::Format::eBc5UnormBlock:
+        case vk::Format::eBc5SnormBlock:
+        case vk::Format::eBc6HUfloatBlock:
+        case vk::Format::eBc6HSfloatBlock:
+        case vk::Format::eBc7UnormBlock:
+        case vk::Format::eBc7SrgbBlock:
+        case vk::Format::eR32G32B32A32Sfloat: return 16;
+        case vk::Format::eA2B10G10R10UnormPack32:
+        case vk::Format::eB10G11R11UfloatPack32:
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eB8G8R8A8Unorm:
+        case vk::Format::eB8G8R8A8Srgb:
+        case vk::Format::eR16G16Sfloat:
+        case vk::Format::eR16G16Unorm:
+        case vk::Format::eR32Sfloat: return 4;
+        case vk::Format::eR8G8Unorm:
+        case vk::Format::eR16Sfloat:
+        case vk::Format::eR16Unorm: return 2;
+        case vk::Format::eR8Unorm: return 1;
+        default: return 0;
+        }
+    }
+
+    bool IsCompressed(const vk::Format format)
+    {
+        return format >= vk::Format::eBc1RgbUnormBlock && format <= vk::Format::eBc7SrgbBlock;
+    }
+} // namespace
+
+namespace Swift::DDS
+{
+    u64 Header::DataSize() const
+    {
+        return (MipOffset(mipLevels) - dataOffset) * arraySize;
+    }
+
+    u64 Header::MipOffset(const u32 mipLevel) const
+    {
+        assert(mipLevel <= mipLevels);
+        u64 offset = dataOffset;
+        for (u32 mip = 0; mip < mipLevel; mip++)
+        {
+            offset += MipSize(mip);
+        }
+        return offset;
+    }
+
+    u64 Header::MipSize(const u32 mipLevel) const
+    {
+        assert(mipLevel < mipLevels);
+        const u64 mipWidth = std::max(width >> mipLevel, 1u);
+        const u64 mipHeight = std::max(height >> mipLevel, 1u);
+        const u64 mipDepth = std::max(depth >> mipLevel, 1u);
+        if (bCompressed)
+        {
+            return (mipWidth + 3) / 4 * ((mipHeight + 3) / 4) * mipDepth * blockSize;
+        }
+        return mipWidth * mipHeight * mipDepth * blockSize;
+    }
+
+    VkImageCreateInfo Header::GetVulkanImageCreateInfo(const vk::ImageUsageFlags usage) const
+    {
+        return VkImageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .flags = bCubemap ? VkImageCreateFlags{VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT} : 0u,
+            .imageType = depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D,
+            .format = static_cast<VkFormat>(format),
+            .extent = {width, height, depth},
+            .mipLevels = mipLevels,
+            .arrayLayers = arraySize,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = static_cast<VkImageUsageFlags>(usage),
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+    }
+
+    VkImageViewCreateInfo Header::GetVulkanImageViewCreateInfo() const
+    {
+        auto viewType = VK_IMAGE_VIEW_TYPE_2D;
+        if (depth > 1)
+        {
+            viewType = VK_IMAGE_VIEW_TYPE_3D;
+        }
+        else if (bCubemap)
+        {
+            viewType = arraySize > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        }
+        else if (arraySize > 1)
+        {
+            viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        }
+        return VkImageViewCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .viewType = viewType,
+            .format = static_cast<VkFormat>(format),
+            .subresourceRange =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = mipLevels,
+                    .baseArrayLayer = 0,
+                    .layerCount = arraySize,
+                },
+        };
+    }
+
+    std::optional<Header> ReadHeader(const std::span<const char> data)
+    {
+        u32 magic;
+        FileHeader fileHeader;
+        if (data.size() < sizeof(magic) + sizeof(fileHeader))
+        {
+            return std::nullopt;
+        }
+        // Copied out rather than cast in place, the mapping makes no promise about alignment
+        std::memcpy(&magic, data.data(), sizeof(magic));
+        std::memcpy(&fileHeader, data.data() + sizeof(magic), sizeof(fileHeader));
+        if (magic != Magic || fileHeader.size != sizeof(FileHeader))
+        {
+            return std::nullopt;
+        }
+
+        Header header;
+        header.width = fileHeader.width;
+        header.height = fileHeader.height;
+        // Writers are not required to clear the depth of 2D textures
+        const bool bVolume = (fileHeader.flags & FlagDepth) || (fileHeader.caps2 & Caps2Volume);
+        header.depth = bVolume ? std::max(fileHeader.depth, 1u) : 1;
+        header.mipLevels = std::max(fileHeader.mipMapCount, 1u);
+        header.dataOffset = sizeof(magic) + sizeof(fileHeader);
+
+        const auto& pixelFormat = fileHeader.pixelFormat;
+        if ((pixelFormat.flags & PixelFormatFourCC) &&
+            pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0'))
+        {
+            FileHeaderDX10 dx10Header;
+            if (data.size() < header.dataOffset + sizeof(dx10Header))
+            {
+                return std::nullopt;
+            }
+            std::memcpy(&dx10Header, data.data() + header.dataOffset, sizeof(dx10Header));
+            header.dataOffset += sizeof(dx10Header);
+            header.format = GetFormatFromDXGI(dx10Header.dxgiFormat);
+            header.bCubemap = dx10Header.miscFlag & MiscTextureCube;
+            const u64 arraySize =
+                static_cast<u64>(std::max(dx10Header.arraySize, 1u)) * (header.bCubemap ? 6 : 1);
+            if (arraySize > MaxDimension)
+            {
+                return std::nullopt;
+            }
+            header.arraySize = static_cast<u32>(arraySize);
+            header.depth = dx10Header.resourceDimension == Dimension3D
+                               ? std::max(fileHeader.depth, 1u)
+                               : 1;
+        }
+        else
+        {
+            header.format = GetLegacyFormat(pixelFormat);
+            header.bCubemap = fileHeader.caps2 & Caps2Cubemap;
+            header.arraySize = header.bCubemap ? 6 : 1;
+        }
+
+        header.blockSize = GetBlockSize(header.format);
+        header.bCompressed = IsCompressed(header.format);
+        if (header.blockSize == 0 || header.width == 0 || header.height == 0)
+        {
+            return std::nullopt;
+        }
+        const auto largestDimension = std::max({header.width, header.height, header.depth});
+        if (largestDimension > MaxDimension)
+        {
+            return std::nullopt;
+        }
+        // A chain longer than the one that halves down to 1x1 would shift past the type's width
+        const auto fullMipCount = static_cast<u32>(std::bit_width(largestDimension));
+        if (header.mipLevels > fullMipCount)
+        {
+            return std::nullopt;
+        }
+
+        // Divided rather than multiplied out by the layer count so huge counts cannot wrap
+        const auto layerSize = header.MipOffset(header.mipLevels) - header.dataOffset;
+        if (header.dataOffset > data.size() ||
+            layerSize > (data.size() - header.dataOffset) / header.arraySize)
+        {
+            return std::nullopt;
+        }
+        return header;
+    }
+} // namespace Swift::DDS
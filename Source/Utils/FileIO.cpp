@@ -1,5 +1,16 @@
 #include "Utils/FileIO.hpp"
 
+#ifdef SWIFT_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 std::vector<char> FileIO::ReadBinaryFile(const std::string_view filePath)
 {
     std::ifstream file(filePath.data(), std::ios::binary | std::ios::ate);
@@ -15,3 +26,117 @@ std::vector<char> FileIO::ReadBinaryFile(const std::string_view filePath)
     assert(false);
     return {};
 };
+
+bool FileIO::WriteBinaryFile(
+    const std::string_view filePath,
+    const std::span<const char> data)
+{
+    const std::filesystem::path path(filePath);
+    auto tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file)
+        {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+MappedFile FileIO::MapFile(const std::string_view filePath)
+{
+    const std::string path(filePath);
+    MappedFile mappedFile;
+#ifdef SWIFT_WINDOWS
+    const auto file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return {};
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return {};
+    }
+    const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return {};
+    }
+    mappedFile.data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    mappedFile.size = static_cast<u64>(size.QuadPart);
+    mappedFile.fileHandle = file;
+    mappedFile.mappingHandle = mapping;
+    if (!mappedFile.data)
+    {
+        UnmapFile(mappedFile);
+        return {};
+    }
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        return {};
+    }
+    struct stat fileStat{};
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return {};
+    }
+    const auto size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return {};
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, size, MADV_WILLNEED);
+    mappedFile.data = static_cast<const char*>(data);
+    mappedFile.size = size;
+#endif
+    return mappedFile;
+}
+
+void FileIO::UnmapFile(MappedFile& file)
+{
+#ifdef SWIFT_WINDOWS
+    if (file.data)
+    {
+        UnmapViewOfFile(file.data);
+    }
+    if (file.mappingHandle)
+    {
+        CloseHandle(file.mappingHandle);
+    }
+    if (file.fileHandle)
+    {
+        CloseHandle(file.fileHandle);
+    }
+#else
+    if (file.data)
+    {
+        munmap(const_cast<char*>(file.data), file.size);
+    }
+#endif
+    file = {};
+}
@@ -0,0 +1,229 @@
+#include "Utils/JobSystem.hpp"
+
+namespace
+{
+    // Workers know their own deque, every other thread uses the shared one at the back
+    thread_local const Swift::JobSystem* tJobSystem = nullptr;
+    thread_local u32 tWorkerIndex = 0;
+} // namespace
+
+namespace Swift
+{
+    JobSystem::JobSystem(const u32 threadCount)
+    {
+        queues.reserve(threadCount + 1);
+        for (u32 i = 0; i < threadCount + 1; i++)
+        {
+            queues.emplace_back(std::make_unique<JobQueue>());
+        }
+        threads.reserve(threadCount);
+        for (u32 i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::scoped_lock lock(sleepMutex);
+            bStopping = true;
+        }
+        condition.notify_all();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void JobSystem::Submit(
+        std::function<void()> job,
+        JobCounter* counter,
+        JobCounter* dependency)
+    {
+        if (counter)
+        {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto counted = [this, job = std::move(job), counter]
+        {
+            job();
+            Finish(counter);
+        };
+        if (dependency)
+        {
+            // Checked under the lock Finish takes to release continuations, so the job is either
+            // queued here or released there, never both or neither
+            std::scoped_lock lock(dependency->mutex);
+            if (!dependency->IsDone())
+            {
+                dependency->continuations.emplace_back(std::move(counted));
+                return;
+            }
+        }
+        Push(std::move(counted));
+    }
+
+    void JobSystem::Wait(const JobCounter& counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (RunOne())
+            {
+                continue;
+            }
+            // Nothing to help with, so sleep until a job is queued or Finish completes the counter
+            std::unique_lock lock(sleepMutex);
+            condition.wait(
+                lock,
+                [this, &counter]
+                {
+                    return counter.IsDone() || queuedJobs.load(std::memory_order_acquire) != 0;
+                });
+        }
+        // The last job drops the count while holding the lock, so once it is free the counter
+        // is no longer touched and the caller may destroy it
+        std::scoped_lock lock(counter.mutex);
+    }
+
+    void JobSystem::ParallelFor(
+        const u32 count,
+        const u32 grainSize,
+        const std::function<void(u32 first, u32 last)>& function)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        JobCounter counter;
+        SubmitRange(0, count, std::max(grainSize, 1u), function, counter);
+        Wait(counter);
+    }
+
+    void JobSystem::Push(std::function<void()> job)
+    {
+        const auto queueIndex = tJobSystem == this ? tWorkerIndex : GetThreadCount();
+        auto& queue = *queues[queueIndex];
+        queuedJobs.fetch_add(1, std::memory_order_release);
+        {
+            std::scoped_lock lock(queue.mutex);
+            queue.jobs.emplace_back(std::move(job));
+        }
+        // Taking the lock orders the push before a worker that is about to sleep checks for work
+        {
+            std::scoped_lock lock(sleepMutex);
+        }
+        condition.notify_one();
+    }
+
+    bool JobSystem::RunOne()
+    {
+        if (queuedJobs.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+
+        const auto ownIndex = tJobSystem == this ? tWorkerIndex : GetThreadCount();
+        std::function<void()> job;
+        {
+            auto& queue = *queues[ownIndex];
+            std::scoped_lock lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            }
+        }
+        for (u32 offset = 1; !job && offset < queues.size(); offset++)
+        {
+            auto& queue = *queues[(ownIndex + offset) % queues.size()];
+            std::scoped_lock lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+        }
+        if (!job)
+        {
+            return false;
+        }
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        job();
+        return true;
+    }
+
+    void JobSystem::Finish(JobCounter* counter)
+    {
+        if (!counter)
+        {
+            return;
+        }
+        std::vector<std::function<void()>> continuations;
+        {
+            std::scoped_lock lock(counter->mutex);
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+            continuations.swap(counter->continuations);
+        }
+        for (auto& continuation : continuations)
+        {
+            Push(std::move(continuation));
+        }
+        // Wakes threads sleeping in Wait, the lock orders this after their last check
+        {
+            std::scoped_lock lock(sleepMutex);
+        }
+        condition.notify_all();
+    }
+
+    void JobSystem::SubmitRange(
+        const u32 first,
+        const u32 last,
+        const u32 grainSize,
+        const std::function<void(u32 first, u32 last)>& function,
+        JobCounter& counter)
+    {
+        Submit(
+            [this, first, last, grainSize, &function, &counter]
+            {
+                // Hands the upper half to whoever steals it and keeps splitting the lower one
+                auto end = last;
+                while (end - first > grainSize)
+                {
+                    const auto middle = first + (end - first) / 2;
+                    SubmitRange(middle, end, grainSize, function, counter);
+                    end = middle;
+                }
+                function(first, end);
+            },
+            &counter);
+    }
+
+    void JobSystem::WorkerLoop(const u32 workerIndex)
+    {
+        tJobSystem = this;
+        tWorkerIndex = workerIndex;
+        while (true)
+        {
+            if (RunOne())
+            {
+                continue;
+            }
+            std::unique_lock lock(sleepMutex);
+            condition.wait(
+                lock,
+                [this]
+                {
+                    return bStopping || queuedJobs.load(std::memory_order_acquire) != 0;
+                });
+            // Queued jobs are drained before shutting down so no counter is left waiting
+            if (bStopping && queuedJobs.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+} // namespace Swift
@@ -0,0 +1,51 @@
+#include "Utils/ThreadPool.hpp"
+
+namespace Swift
+{
+    ThreadPool::ThreadPool(const u32 threadCount)
+    {
+        threads.reserve(threadCount);
+        for (u32 i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::scoped_lock lock(mutex);
+            bStopping = true;
+        }
+        condition.notify_all();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex);
+                condition.wait(
+                    lock,
+                    [this]
+                    {
+                        return bStopping || !tasks.empty();
+                    });
+                // Drain whatever is queued before shutting down so no future is left hanging
+                if (tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+} // namespace Swift
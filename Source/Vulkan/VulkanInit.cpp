@@ -1,13 +1,31 @@
 #include "Vulkan/VulkanInit.hpp"
 #include "GLFW/glfw3.h"
+#include "Utils/DDS.hpp"
 #include "Utils/FileIO.hpp"
 #include "Vulkan/VulkanConstants.hpp"
 #include "Vulkan/VulkanStructs.hpp"
 #include "Vulkan/VulkanUtil.hpp"
-#include "dds.hpp"
 
 namespace
 {
+    // The header is parsed from the mapping, so each file is opened once. Empty when the file is
+    // missing or is not a DDS file Vulkan can sample, the mapping is released then.
+    std::optional<std::pair<
+        MappedFile,
+        Swift::DDS::Header>>
+    MapDDSFile(const std::string_view filePath)
+    {
+        auto file = FileIO::MapFile(filePath);
+        const auto header =
+            file ? Swift::DDS::ReadHeader(std::span(file.data, file.size)) : std::nullopt;
+        if (!header)
+        {
+            FileIO::UnmapFile(file);
+            return std::nullopt;
+        }
+        return std::pair{file, header.value()};
+    }
+
     bool CheckQueueSupport(
         const vk::PhysicalDevice physicalDevice,
         const vk::SurfaceKHR surface)
@@ -19,8 +37,11 @@ namespace
         {
             if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
             {
-                const auto support = physicalDevice.getSurfaceSupportKHR(index, surface);
-                VK_ASSERT(support.result, "Failed to get surface support for queue family");
+                if (surface)
+                {
+                    const auto support = physicalDevice.getSurfaceSupportKHR(index, surface);
+                    VK_ASSERT(support.result, "Failed to get surface support for queue family");
+                }
                 graphicsFamily = static_cast<u32>(index);
                 break;
             }
@@ -88,7 +109,8 @@ namespace
 
     vk::Instance CreateInstance(
         const std::string_view appName,
-        const std::string_view engineName)
+        const std::string_view engineName,
+        const bool headless)
     {
         const auto appInfo = vk::ApplicationInfo()
                                  .setApplicationVersion(vk::ApiVersion10)
@@ -97,25 +119,30 @@ namespace
                                  .setPApplicationName(appName.data())
                                  .setPEngineName(engineName.data());
 
-        const std::vector extensions{
-            VK_KHR_SURFACE_EXTENSION_NAME,
+        std::vector<const char*> extensions{
 #ifdef SWIFT_VULKAN_VALIDATION
             VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
-#endif
-#ifdef SWIFT_WINDOWS
-            "VK_KHR_win32_surface",
-#else
-            "VK_KHR_xcb_surface",
 #endif
         };
-        const std::vector layers{
-            "VK_LAYER_LUNARG_monitor",
+        std::vector<const char*> layers{
             "VK_LAYER_KHRONOS_shader_object",
 #ifdef SWIFT_VULKAN_VALIDATION
             "VK_LAYER_KHRONOS_validation"
 #endif
         };
 
+        // Headless instances don't need any window system integration
+        if (!headless)
+        {
+            extensions.emplace_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef SWIFT_WINDOWS
+            extensions.emplace_back("VK_KHR_win32_surface");
+#else
+            extensions.emplace_back("VK_KHR_xcb_surface");
+#endif
+            layers.emplace_back("VK_LAYER_LUNARG_monitor");
+        }
+
         const auto createInfo = vk::InstanceCreateInfo()
                                     .setPApplicationInfo(&appInfo)
                                     .setPEnabledExtensionNames(extensions)
@@ -130,6 +157,10 @@ namespace
         const Swift::Vulkan::Context& context,
         const Swift::InitInfo& initInfo)
     {
+        if (initInfo.bHeadless)
+        {
+            return {};
+        }
         if (std::holds_alternative<GLFWwindow*>(initInfo.windowHandle))
         {
             VkSurfaceKHR surface;
@@ -190,9 +221,17 @@ namespace
                 continue;
             }
 
-            std::vector extensions{
-                VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-                VK_EXT_IMAGE_VIEW_MIN_LOD_EXTENSION_NAME};
+            // Compacted indirect draws carry their draw index in firstInstance
+            if (!deviceFeatures.features.drawIndirectFirstInstance)
+            {
+                continue;
+            }
+
+            std::vector extensions{VK_EXT_IMAGE_VIEW_MIN_LOD_EXTENSION_NAME};
+            if (!initInfo.bHeadless)
+            {
+                extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+            }
             if (initInfo.bUsePipelines)
             {
                 extensions.emplace_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
@@ -250,7 +289,7 @@ namespace
             }
 
             // Check support for swap chain.
-            if (!CheckSwapchainSupport(device, context.surface))
+            if (!initInfo.bHeadless && !CheckSwapchainSupport(device, context.surface))
             {
                 continue;
             }
@@ -279,9 +318,11 @@ namespace
         const Swift::Vulkan::Context& context,
         const Swift::InitInfo& initInfo)
     {
-        std::vector extensionNames{
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-            VK_EXT_IMAGE_VIEW_MIN_LOD_EXTENSION_NAME};
+        std::vector extensionNames{VK_EXT_IMAGE_VIEW_MIN_LOD_EXTENSION_NAME};
+        if (!initInfo.bHeadless)
+        {
+            extensionNames.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
 
         std::vector<const char*> layerNames;
 
@@ -342,7 +383,8 @@ namespace
             .setDescriptorBindingStorageImageUpdateAfterBind(true)
             .setDescriptorBindingUniformBufferUpdateAfterBind(true)
             .setRuntimeDescriptorArray(true)
-            .setDrawIndirectCount(true);
+            .setDrawIndirectCount(true)
+            .setTimelineSemaphore(true);
 
         auto& features13 =
             initInfo.bUsePipelines
@@ -354,6 +396,7 @@ namespace
         constexpr auto deviceFeatures = vk::PhysicalDeviceFeatures()
                                             .setSamplerAnisotropy(true)
                                             .setMultiDrawIndirect(true)
+                                            .setDrawIndirectFirstInstance(true)
                                             .setShaderSampledImageArrayDynamicIndexing(true)
                                             .setShaderStorageBufferArrayDynamicIndexing(true)
                                             .setShaderUniformBufferArrayDynamicIndexing(true)
@@ -391,10 +434,19 @@ namespace
 
         const auto indices =
             Swift::Vulkan::Util::GetQueueFamilyIndices(context.gpu, context.surface);
+        // Queues may share a family on devices with a single queue family (e.g. lavapipe)
+        std::vector<u32> uniqueIndices;
+        for (const auto family : indices)
+        {
+            if (std::ranges::find(uniqueIndices, family) == uniqueIndices.end())
+            {
+                uniqueIndices.emplace_back(family);
+            }
+        }
         std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
         auto queueProps = context.gpu.getQueueFamilyProperties();
         std::array<std::vector<float>, 3> priorities;
-        for (const auto [index, family] : std::views::enumerate(indices))
+        for (const auto [index, family] : std::views::enumerate(uniqueIndices))
         {
             auto queueCount = queueProps[family].queueCount;
             priorities[index].resize(queueCount, 1.0f);
@@ -432,11 +484,30 @@ namespace
         return allocator;
     }
 
+    // Passing the device makes every device level entry point come from vkGetDeviceProcAddr, so
+    // calls dispatched through it skip the loader's trampolines
     vk::detail::DispatchLoaderDynamic CreateDynamicLoader(const Swift::Vulkan::Context& context)
     {
         return {context.instance, vkGetInstanceProcAddr, context.device, vkGetDeviceProcAddr};
     }
 
+    bool IsPipelineCacheCompatible(
+        const vk::PhysicalDevice gpu,
+        const std::span<const char> data)
+    {
+        vk::PipelineCacheHeaderVersionOne header;
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        const auto props = gpu.getProperties();
+        return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+               header.headerVersion == vk::PipelineCacheHeaderVersion::eOne &&
+               header.vendorID == props.vendorID && header.deviceID == props.deviceID &&
+               header.pipelineCacheUUID == props.pipelineCacheUUID;
+    }
+
     vk::ImageView CreateImageView(
         const Swift::Vulkan::Context& context,
         const vk::Image image,
@@ -633,7 +704,7 @@ namespace
                                     .setPColorBlendState(&colorBlendStateCreateInfo);
 
         const auto [result, graphicsPipeline] =
-            context.device.createGraphicsPipeline(nullptr, createInfo);
+            context.device.createGraphicsPipeline(context.pipelineCache, createInfo);
         VK_ASSERT(result, "Failed to create graphics pipeline!");
 
         for (const auto& shader : shaderModules)
@@ -652,25 +723,36 @@ namespace
         const auto stage = CreateShaderStage(vk::ShaderStageFlagBits::eCompute, shaderModule);
         const auto createInfo = vk::ComputePipelineCreateInfo().setLayout(layout).setStage(stage);
         const auto [result, computePipeline] =
-            context.device.createComputePipeline(nullptr, createInfo);
+            context.device.createComputePipeline(context.pipelineCache, createInfo);
         VK_ASSERT(result, "Failed to create compute pipeline!");
         return computePipeline;
     }
 
     vk::PipelineLayout CreatePipelineLayout(
-        Swift::Vulkan::Context context,
-        Swift::Vulkan::BindlessDescriptor descriptor,
-        vk::PushConstantRange pushConstantRange)
+        const Swift::Vulkan::Context& context,
+        const Swift::Vulkan::BindlessDescriptor& descriptor,
+        Swift::Vulkan::PipelineLayoutCache& layoutCache,
+        const vk::PushConstantRange pushConstantRange)
     {
+        using namespace Swift::Vulkan;
+        std::scoped_lock lock(layoutCache.mutex);
+        auto key = Util::HashValue(static_cast<VkDescriptorSetLayout>(descriptor.setLayout));
+        key = Util::HashValue(static_cast<VkPushConstantRange>(pushConstantRange), key);
+        if (const auto it = layoutCache.layouts.find(key); it != layoutCache.layouts.end())
+        {
+            return it->second;
+        }
+
         auto layoutCreateInfo = vk::PipelineLayoutCreateInfo().setSetLayouts(descriptor.setLayout);
         if (pushConstantRange.size > 0)
         {
             layoutCreateInfo.setPushConstantRanges(pushConstantRange);
         }
-        // TODO: cache similar pipeline layouts
         const auto [pipeResult, pipelineLayout] =
             context.device.createPipelineLayout(layoutCreateInfo);
         VK_ASSERT(pipeResult, "Failed to create pipeline layout for shader!");
+        Util::NameObject(pipelineLayout, "Pipeline Layout", context);
+        layoutCache.layouts.emplace(key, pipelineLayout);
         return pipelineLayout;
     }
 } // namespace
@@ -680,19 +762,23 @@ namespace Swift::Vulkan
     Context Init::CreateContext(const InitInfo& initInfo)
     {
         Context context;
-        context.SetInstance(CreateInstance(initInfo.appName, initInfo.engineName))
+        context
+            .SetInstance(
+                CreateInstance(initInfo.appName, initInfo.engineName, initInfo.bHeadless))
             .SetSurface(CreateSurface(context, initInfo))
             .SetGPU(ChooseGPU(context, initInfo))
             .SetDevice(CreateDevice(context, initInfo))
             .SetAllocator(CreateAllocator(context))
-            .SetDynamicLoader(CreateDynamicLoader(context));
+            .SetDynamicLoader(CreateDynamicLoader(context))
+            .SetPipelineCache(CreatePipelineCache(context, initInfo.pipelineCachePath));
         return context;
     }
 
     vk::SwapchainKHR Init::CreateSwapchain(
         const Context& context,
         const vk::Extent2D extent,
-        const u32 queueIndex)
+        const u32 queueIndex,
+        const vk::SwapchainKHR oldSwapchain)
     {
         const auto& device = context.device;
         const auto& gpu = context.gpu;
@@ -707,13 +793,15 @@ namespace Swift::Vulkan
                 .setImageFormat(format)
                 .setImageColorSpace(colorSpace)
                 .setMinImageCount(Util::GetSwapchainImageCount(gpu, surface))
-                .setImageExtent(extent)
+                .setImageExtent(Util::GetSwapchainExtent(gpu, surface, extent))
                 .setImageArrayLayers(1)
                 .setImageUsage(
-                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst)
+                    vk::ImageUsageFlagBits::eColorAttachment |
+                    vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc)
                 .setImageSharingMode(vk::SharingMode::eExclusive)
                 .setQueueFamilyIndices(queueIndex)
-                .setPreTransform(ChooseSwapchainPreTransform(gpu, surface));
+                .setPreTransform(ChooseSwapchainPreTransform(gpu, surface))
+                .setOldSwapchain(oldSwapchain);
         const auto [result, swapchain] = device.createSwapchainKHR(createInfo);
         Util::NameObject(swapchain, "Swapchain", context);
         VK_ASSERT(result, "Failed to create swapchain");
@@ -767,7 +855,8 @@ namespace Swift::Vulkan
             .SetAllocation(allocation)
             .SetFormat(static_cast<vk::Format>(imageCreateInfo.format))
             .SetView(imageView)
-            .SetExtent(imageCreateInfo.extent);
+            .SetExtent(imageCreateInfo.extent)
+            .SetMipLevels(imageCreateInfo.mipLevels);
     }
 
     Image Init::CreateImage(
@@ -846,22 +935,33 @@ namespace Swift::Vulkan
             .SetAllocation(allocation)
             .SetFormat(createInfo.format)
             .SetView(imageView)
-            .SetExtent(extent);
+            .SetExtent(extent)
+            .SetMipLevels(mipLevels);
     }
 
-    std::tuple<
+    std::optional<std::tuple<
         Image,
-        Buffer>
+        Buffer,
+        vk::ImageMemoryBarrier2>>
     Init::CreateDDSImage(
         const Context& context,
         Queue transferQueue,
         Command transferCommand,
+        const u32 dstQueueFamily,
         const std::filesystem::path& filePath,
         int maxMipLevel,
         const bool loadAllMips,
+        StagingRing& stagingRing,
+        const u64 ticket,
         const std::string_view debugName)
     {
-        dds::Header header = dds::ReadHeader(filePath.string());
+        // The payload is copied straight from the mapping into staging memory
+        auto mappedFile = MapDDSFile(filePath.string());
+        if (!mappedFile)
+        {
+            return std::nullopt;
+        }
+        auto& [file, header] = mappedFile.value();
 
         auto imageCreateInfo = header.GetVulkanImageCreateInfo(
             vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
@@ -901,17 +1001,20 @@ namespace Swift::Vulkan
             vk::ImageAspectFlagBits::eColor,
             mipCount,
             imageCreateInfo.arrayLayers);
-        Util::PipelineBarrier(transferCommand, srcImageBarrier);
+        Util::PipelineBarrier(context, transferCommand, srcImageBarrier);
 
         const auto buffer = Util::UploadToImage(
             context,
             transferCommand,
             transferQueue.index,
             header,
-            filePath.string(),
+            file,
             maxMipLevel,
             loadAllMips,
-            image);
+            image,
+            stagingRing,
+            ticket);
+        FileIO::UnmapFile(file);
 
         const auto dstImageBarrier = Util::ImageBarrier(
             image.currentLayout,
@@ -919,10 +1022,181 @@ namespace Swift::Vulkan
             image,
             vk::ImageAspectFlagBits::eColor,
             mipCount,
+            imageCreateInfo.arrayLayers,
+            transferQueue.index,
+            dstQueueFamily);
+        Util::PipelineBarrier(context, transferCommand, dstImageBarrier);
+
+        return std::tuple{image, buffer, dstImageBarrier};
+    }
+
+    std::optional<std::tuple<
+        Image,
+        Buffer,
+        vk::ImageMemoryBarrier2>>
+    Init::CreateProgressiveDDSImage(
+        const Context& context,
+        const Queue transferQueue,
+        const Command transferCommand,
+        const u32 dstQueueFamily,
+        const std::filesystem::path& filePath,
+        int residentMip,
+        StagingRing& stagingRing,
+        const u64 ticket,
+        const std::string_view debugName)
+    {
+        auto mappedFile = MapDDSFile(filePath.string());
+        if (!mappedFile)
+        {
+            return std::nullopt;
+        }
+        auto& [file, header] = mappedFile.value();
+
+        // Same chain as CreateDDSImage, which stops at the 4x4 block size
+        const auto mipCount = static_cast<int>(std::log2(std::max(header.Width() / 4, 1u))) + 1;
+        residentMip = std::clamp(residentMip, 0, mipCount - 1);
+
+        auto imageCreateInfo = header.GetVulkanImageCreateInfo(
+            vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+        imageCreateInfo.mipLevels = mipCount;
+        auto minLodCreateInfo = VkImageViewMinLodCreateInfoEXT{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_MIN_LOD_CREATE_INFO_EXT,
+            .minLod = static_cast<float>(residentMip),
+        };
+        auto imageViewCreateInfo = header.GetVulkanImageViewCreateInfo();
+        imageViewCreateInfo.subresourceRange.levelCount = mipCount;
+        imageViewCreateInfo.pNext = &minLodCreateInfo;
+
+        auto image = CreateImage(context, imageCreateInfo, imageViewCreateInfo, debugName)
+                         .SetMinLod(static_cast<float>(residentMip))
+                         .SetMaxLod(static_cast<float>(mipCount - 1))
+                         .SetURI(filePath.string());
+
+        // The levels finer than residentMip are transitioned along with the rest but stay
+        // undefined until they are uploaded, the min LOD keeps them from being sampled
+        const auto srcImageBarrier = Util::ImageBarrier(
+            image.currentLayout,
+            vk::ImageLayout::eTransferDstOptimal,
+            image,
+            vk::ImageAspectFlagBits::eColor,
+            mipCount,
             imageCreateInfo.arrayLayers);
-        Util::PipelineBarrier(transferCommand, dstImageBarrier);
+        Util::PipelineBarrier(context, transferCommand, srcImageBarrier);
+
+        const auto buffer = Util::UploadToImage(
+            context,
+            transferCommand,
+            transferQueue.index,
+            header,
+            file,
+            residentMip,
+            true,
+            image,
+            stagingRing,
+            ticket,
+            residentMip);
+        FileIO::UnmapFile(file);
+
+        const auto dstImageBarrier = Util::ImageBarrier(
+            image.currentLayout,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            image,
+            vk::ImageAspectFlagBits::eColor,
+            mipCount,
+            imageCreateInfo.arrayLayers,
+            transferQueue.index,
+            dstQueueFamily);
+        Util::PipelineBarrier(context, transferCommand, dstImageBarrier);
+
+        return std::tuple{image, buffer, dstImageBarrier};
+    }
+
+    std::optional<std::tuple<
+        Buffer,
+        vk::ImageMemoryBarrier2>>
+    Init::UploadDDSMip(
+        const Context& context,
+        const Queue transferQueue,
+        const Command transferCommand,
+        const u32 dstQueueFamily,
+        Image& image,
+        const int mipLevel,
+        StagingRing& stagingRing,
+        const u64 ticket)
+    {
+        assert(mipLevel >= 0 && mipLevel < static_cast<int>(image.mipLevels));
+        auto mappedFile = MapDDSFile(image.uri);
+        if (!mappedFile)
+        {
+            return std::nullopt;
+        }
+        auto& [file, header] = mappedFile.value();
+
+        // The level has never been written, so its old contents can be discarded without taking
+        // ownership back from the graphics queue
+        const auto srcImageBarrier = Util::ImageBarrier(
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eTransferDstOptimal,
+            image,
+            vk::ImageAspectFlagBits::eColor,
+            1,
+            header.ArraySize(),
+            vk::QueueFamilyIgnored,
+            vk::QueueFamilyIgnored,
+            mipLevel);
+        Util::PipelineBarrier(context, transferCommand, srcImageBarrier);
+
+        const auto buffer = Util::UploadToImage(
+            context,
+            transferCommand,
+            transferQueue.index,
+            header,
+            file,
+            mipLevel,
+            false,
+            image,
+            stagingRing,
+            ticket,
+            mipLevel);
+        FileIO::UnmapFile(file);
 
-        return {image, buffer};
+        const auto dstImageBarrier = Util::ImageBarrier(
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            image,
+            vk::ImageAspectFlagBits::eColor,
+            1,
+            header.ArraySize(),
+            transferQueue.index,
+            dstQueueFamily,
+            mipLevel);
+        Util::PipelineBarrier(context, transferCommand, dstImageBarrier);
+
+        return std::tuple{buffer, dstImageBarrier};
+    }
+
+    vk::ImageView Init::CreateMinLodImageView(
+        const Context& context,
+        const Image& image,
+        const int minLod,
+        const std::string_view debugName)
+    {
+        const auto minLodCreateInfo =
+            vk::ImageViewMinLodCreateInfoEXT().setMinLod(static_cast<float>(minLod));
+        const auto viewCreateInfo =
+            vk::ImageViewCreateInfo()
+                .setPNext(&minLodCreateInfo)
+                .setImage(image)
+                .setFormat(image.format)
+                .setViewType(vk::ImageViewType::e2D)
+                .setSubresourceRange(Util::GetImageSubresourceRange(
+                    vk::ImageAspectFlagBits::eColor,
+                    image.mipLevels));
+
+        const auto [result, imageView] = context.device.createImageView(viewCreateInfo);
+        VK_ASSERT(result, "Failed to create image view");
+        Util::NameObject(imageView, debugName, context);
+        return imageView;
     }
 
     std::vector<Image> Init::CreateSwapchainImages(
@@ -949,23 +1223,53 @@ namespace Swift::Vulkan
         return swapchainImages;
     }
 
+    std::vector<Image> Init::CreateHeadlessImages(
+        const Context& context,
+        const vk::Extent2D extent,
+        const u32 imageCount)
+    {
+        std::vector<Image> images;
+        images.reserve(imageCount);
+        for (u32 i = 0; i < imageCount; i++)
+        {
+            auto image = CreateImage(
+                context,
+                vk::ImageType::e2D,
+                vk::Extent3D(extent, 1),
+                vk::Format::eB8G8R8A8Unorm,
+                vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst |
+                    vk::ImageUsageFlagBits::eTransferSrc,
+                1,
+                {},
+                "Headless");
+            images.emplace_back(image);
+        }
+        return images;
+    }
+
     Buffer Init::CreateBuffer(
         const Context& context,
         u32 queueFamilyIndex,
         const vk::DeviceSize size,
         const vk::BufferUsageFlags bufferUsageFlags,
         const bool readback,
-        const std::string_view debugName)
+        const std::string_view debugName,
+        const std::span<const u32> concurrentQueueFamilies)
     {
         const auto props = context.gpu.getProperties();
         const auto uboAlignment = props.limits.minUniformBufferOffsetAlignment;
         const auto storageAlignment = props.limits.minStorageBufferOffsetAlignment;
 
-        const auto createInfo = vk::BufferCreateInfo()
-                                    .setQueueFamilyIndices(queueFamilyIndex)
-                                    .setSharingMode(vk::SharingMode::eExclusive)
-                                    .setSize(size)
-                                    .setUsage(bufferUsageFlags);
+        auto createInfo = vk::BufferCreateInfo()
+                              .setQueueFamilyIndices(queueFamilyIndex)
+                              .setSharingMode(vk::SharingMode::eExclusive)
+                              .setSize(size)
+                              .setUsage(bufferUsageFlags);
+        if (concurrentQueueFamilies.size() > 1)
+        {
+            createInfo.setQueueFamilyIndices(concurrentQueueFamilies)
+                .setSharingMode(vk::SharingMode::eConcurrent);
+        }
         const auto cCreateInfo = static_cast<VkBufferCreateInfo>(createInfo);
         const auto isUBO = bufferUsageFlags & vk::BufferUsageFlagBits::eUniformBuffer;
 
@@ -1004,6 +1308,25 @@ namespace Swift::Vulkan
         return Buffer().SetBuffer(buffer).SetAllocation(allocation).SetAllocationInfo(info);
     }
 
+    StagingRing Init::CreateStagingRing(
+        const Context& context,
+        const u32 queueFamilyIndex,
+        const vk::DeviceSize size,
+        const std::string_view debugName)
+    {
+        const auto buffer = CreateBuffer(
+            context,
+            queueFamilyIndex,
+            size,
+            vk::BufferUsageFlagBits::eTransferSrc,
+            false,
+            debugName);
+        return StagingRing()
+            .SetBuffer(buffer)
+            .SetMapped(Util::MapBuffer(context, buffer))
+            .SetCapacity(size);
+    }
+
     vk::Fence Init::CreateFence(
         const Context& context,
         const vk::FenceCreateFlags flags,
@@ -1025,15 +1348,31 @@ namespace Swift::Vulkan
         return semaphore;
     }
 
+    vk::Semaphore Init::CreateTimelineSemaphore(
+        const Context& context,
+        const u64 initialValue,
+        const std::string_view debugName)
+    {
+        auto typeCreateInfo = vk::SemaphoreTypeCreateInfo()
+                                  .setSemaphoreType(vk::SemaphoreType::eTimeline)
+                                  .setInitialValue(initialValue);
+        auto [result, semaphore] =
+            context.device.createSemaphore(vk::SemaphoreCreateInfo().setPNext(&typeCreateInfo));
+        VK_ASSERT(result, "Failed to create timeline semaphore");
+        Util::NameObject(semaphore, debugName, context);
+        return semaphore;
+    }
+
     vk::CommandBuffer Init::CreateCommandBuffer(
         const Context& context,
         const vk::CommandPool commandPool,
-        const std::string_view debugName)
+        const std::string_view debugName,
+        const vk::CommandBufferLevel level)
     {
         const auto allocateInfo = vk::CommandBufferAllocateInfo()
                                       .setCommandBufferCount(1)
                                       .setCommandPool(commandPool)
-                                      .setLevel(vk::CommandBufferLevel::ePrimary);
+                                      .setLevel(level);
         auto [result, commandBuffers] = context.device.allocateCommandBuffers(allocateInfo);
         VK_ASSERT(result, "Failed to allocate command buffers");
         Util::NameObject(commandBuffers.front(), debugName, context);
@@ -1077,6 +1416,35 @@ namespace Swift::Vulkan
         return sampler;
     }
 
+    vk::PipelineCache Init::CreatePipelineCache(
+        const Context& context,
+        const std::string_view filePath)
+    {
+        std::vector<char> data;
+        if (!filePath.empty() && std::filesystem::exists(filePath))
+        {
+            data = FileIO::ReadBinaryFile(filePath);
+        }
+        // Drivers are supposed to reject foreign caches themselves, but not all of them do
+        if (!IsPipelineCacheCompatible(context.gpu, data))
+        {
+            data.clear();
+        }
+
+        auto createInfo = vk::PipelineCacheCreateInfo()
+                              .setInitialDataSize(data.size())
+                              .setPInitialData(data.data());
+        auto [result, pipelineCache] = context.device.createPipelineCache(createInfo);
+        if (result != vk::Result::eSuccess && !data.empty())
+        {
+            createInfo.setInitialDataSize(0).setPInitialData(nullptr);
+            std::tie(result, pipelineCache) = context.device.createPipelineCache(createInfo);
+        }
+        VK_ASSERT(result, "Failed to create pipeline cache");
+        Util::NameObject(pipelineCache, "Pipeline Cache", context);
+        return pipelineCache;
+    }
+
     vk::DescriptorSetLayout Init::CreateDescriptorSetLayout(const vk::Device device)
     {
         std::array descriptorBindings = {
@@ -1171,20 +1539,17 @@ namespace Swift::Vulkan
     Shader Init::CreateGraphicsShader(
         Context context,
         BindlessDescriptor descriptor,
+        PipelineLayoutCache& layoutCache,
         bool bUsePipeline,
-        u32 pushConstantSize,
-        std::string_view vertexPath,
-        std::string_view fragmentPath,
+        std::span<char> vertexCode,
+        std::span<char> fragmentCode,
         std::string_view debugName)
     {
-        const auto pushConstantRange = vk::PushConstantRange()
-                                           .setSize(pushConstantSize)
-                                           .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics);
-
-        auto vertexCode = FileIO::ReadBinaryFile(vertexPath);
-        auto fragmentCode = FileIO::ReadBinaryFile(fragmentPath);
+        const auto pushConstantRange =
+            Util::ReflectGraphicsPushConstantRange(vertexCode, fragmentCode);
 
-        const auto pipelineLayout = CreatePipelineLayout(context, descriptor, pushConstantRange);
+        const auto pipelineLayout =
+            CreatePipelineLayout(context, descriptor, layoutCache, pushConstantRange);
 
         std::vector<vk::ShaderEXT> shadersExt;
         vk::Pipeline pipeline;
@@ -1207,30 +1572,32 @@ namespace Swift::Vulkan
             vk::ShaderStageFlagBits::eFragment,
         };
 
-        Util::NameObject(pipelineLayout, debugName, context);
+        // The layout may be shared with other shaders, so only the pipeline carries the name
+        if (bUsePipeline)
+        {
+            Util::NameObject(pipeline, debugName, context);
+        }
 
         return Shader()
             .SetShaders(shadersExt)
             .SetPipeline(pipeline)
             .SetPipelineLayout(pipelineLayout)
-            .SetStageFlags(stageFlags);
+            .SetStageFlags(stageFlags)
+            .SetPushConstantRange(pushConstantRange);
     }
 
     Shader Init::CreateComputeShader(
         Context context,
         BindlessDescriptor descriptor,
+        PipelineLayoutCache& layoutCache,
         bool bUsePipeline,
-        u32 pushConstantSize,
-        std::string_view computePath,
+        std::span<char> computeCode,
         std::string_view debugName)
     {
-        const auto pushConstantRange = vk::PushConstantRange()
-                                           .setSize(pushConstantSize)
-                                           .setStageFlags(vk::ShaderStageFlagBits::eCompute);
-
-        auto computeCode = FileIO::ReadBinaryFile(computePath);
+        const auto pushConstantRange = Util::ReflectComputePushConstantRange(computeCode);
 
-        const auto pipelineLayout = CreatePipelineLayout(context, descriptor, pushConstantRange);
+        const auto pipelineLayout =
+            CreatePipelineLayout(context, descriptor, layoutCache, pushConstantRange);
 
         std::vector<vk::ShaderEXT> shadersExt;
         vk::Pipeline pipeline;
@@ -1246,12 +1613,17 @@ namespace Swift::Vulkan
 
         const auto stageFlags = {vk::ShaderStageFlagBits::eCompute};
 
-        Util::NameObject(pipelineLayout, debugName, context);
+        // The layout may be shared with other shaders, so only the pipeline carries the name
+        if (bUsePipeline)
+        {
+            Util::NameObject(pipeline, debugName, context);
+        }
 
         return Shader()
             .SetShaders(shadersExt)
             .SetPipeline(pipeline)
             .SetPipelineLayout(pipelineLayout)
-            .SetStageFlags(stageFlags);
+            .SetStageFlags(stageFlags)
+            .SetPushConstantRange(pushConstantRange);
     }
 } // namespace Swift::Vulkan
\ No newline at end of file
@@ -5,32 +5,39 @@
 namespace Swift::Vulkan
 {
     u32 Render::AcquireNextImage(
-        const Queue& queue,
         const Context& context,
         Swapchain& swapchain,
-        const vk::Semaphore semaphore,
-        const vk::Extent2D extent)
+        const vk::Semaphore semaphore)
     {
         const auto acquireInfo = vk::AcquireNextImageInfoKHR()
                                      .setDeviceMask(1)
                                      .setSemaphore(semaphore)
                                      .setSwapchain(swapchain)
                                      .setTimeout(std::numeric_limits<u64>::max());
-        auto [result, image] = context.device.acquireNextImage2KHR(acquireInfo);
+        // Out of date is an expected result here, so this goes around the asserting wrapper
+        u32 image{};
+        const auto result = vkAcquireNextImage2KHR(
+            context.device,
+            reinterpret_cast<const VkAcquireNextImageInfoKHR*>(&acquireInfo),
+            &image);
 
-        if (result == vk::Result::eSuccess)
+        if (result == VK_SUCCESS)
             return image;
+        if (result == VK_SUBOPTIMAL_KHR)
+        {
+            swapchain.bRecreate = true;
+            return image;
+        }
 
-        Util::HandleSubOptimalSwapchain(queue.index, context, swapchain, extent);
+        assert(result == VK_ERROR_OUT_OF_DATE_KHR && "Failed to acquire swapchain image");
+        swapchain.bRecreate = true;
         return std::numeric_limits<u32>::max();
     }
 
     void Render::Present(
-        const Context& context,
         Swapchain& swapchain,
         const Queue queue,
-        vk::Semaphore semaphore,
-        const vk::Extent2D extent)
+        vk::Semaphore semaphore)
     {
         auto presentInfo = vk::PresentInfoKHR()
                                .setImageIndices(swapchain.imageIndex)
@@ -39,9 +46,10 @@ namespace Swift::Vulkan
         const auto result =
             vkQueuePresentKHR(queue.queue, reinterpret_cast<VkPresentInfoKHR*>(&presentInfo));
 
+        // The swapchain is replaced at the start of the next frame, not in the middle of this one
         if (result != VK_SUCCESS)
         {
-            Util::HandleSubOptimalSwapchain(queue.index, context, swapchain, extent);
+            swapchain.bRecreate = true;
         }
     }
 } // namespace Swift::Vulkan
\ No newline at end of file
@@ -1,9 +1,140 @@
 #include "Vulkan/VulkanUtil.hpp"
 #include "SwiftStructs.hpp"
+#include "Utils/DDS.hpp"
+#include "Utils/FileIO.hpp"
 #include "Vulkan/VulkanConstants.hpp"
 #include "Vulkan/VulkanInit.hpp"
 #include "Vulkan/VulkanStructs.hpp"
-#include "dds.hpp"
+
+namespace
+{
+    // Just enough of the SPIR-V spec to size a push constant block
+    namespace Spirv
+    {
+        constexpr u32 Magic = 0x07230203;
+        constexpr u32 HeaderWords = 5;
+
+        constexpr u32 OpTypeBool = 20;
+        constexpr u32 OpTypeInt = 21;
+        constexpr u32 OpTypeFloat = 22;
+        constexpr u32 OpTypeVector = 23;
+        constexpr u32 OpTypeMatrix = 24;
+        constexpr u32 OpTypeArray = 28;
+        constexpr u32 OpTypeStruct = 30;
+        constexpr u32 OpTypePointer = 32;
+        constexpr u32 OpConstant = 43;
+        constexpr u32 OpVariable = 59;
+        constexpr u32 OpDecorate = 71;
+        constexpr u32 OpMemberDecorate = 72;
+
+        constexpr u32 DecorationArrayStride = 6;
+        constexpr u32 DecorationMatrixStride = 7;
+        constexpr u32 DecorationOffset = 35;
+
+        constexpr u32 StorageClassPushConstant = 9;
+    } // namespace Spirv
+
+    struct SpirvType
+    {
+        u32 opcode{};
+        // Words following the result id
+        std::vector<u32> operands;
+    };
+
+    struct SpirvModule
+    {
+        std::unordered_map<
+            u32,
+            SpirvType>
+            types;
+        std::unordered_map<
+            u32,
+            u32>
+            constants;
+        std::unordered_map<
+            u32,
+            u32>
+            arrayStrides;
+        // Keyed by struct id and member index packed into one value
+        std::unordered_map<
+            u64,
+            u32>
+            memberOffsets;
+        std::unordered_map<
+            u64,
+            u32>
+            matrixStrides;
+        u32 pushConstantPointer{};
+    };
+
+    u64 MemberKey(
+        const u32 structId,
+        const u32 member)
+    {
+        return (static_cast<u64>(structId) << 32) | member;
+    }
+
+    u32 GetSpirvTypeSize(
+        const SpirvModule& spirv,
+        const u32 typeId,
+        const u32 matrixStride = 0)
+    {
+        const auto it = spirv.types.find(typeId);
+        if (it == spirv.types.end())
+        {
+            return 0;
+        }
+        const auto& [opcode, operands] = it->second;
+        switch (opcode)
+        {
+        case Spirv::OpTypeBool:
+            return 4;
+        case Spirv::OpTypeInt:
+        case Spirv::OpTypeFloat:
+            return operands[0] / 8;
+        case Spirv::OpTypeVector:
+            return GetSpirvTypeSize(spirv, operands[0]) * operands[1];
+        case Spirv::OpTypeMatrix:
+        {
+            // Column major, which is what glslc emits for push constants unless told otherwise
+            const auto columnSize =
+                matrixStride > 0 ? matrixStride : GetSpirvTypeSize(spirv, operands[0]);
+            return columnSize * operands[1];
+        }
+        case Spirv::OpTypeArray:
+        {
+            const auto lengthIt = spirv.constants.find(operands[1]);
+            const auto length = lengthIt != spirv.constants.end() ? lengthIt->second : 0;
+            const auto strideIt = spirv.arrayStrides.find(typeId);
+            const auto stride = strideIt != spirv.arrayStrides.end()
+                                    ? strideIt->second
+                                    : GetSpirvTypeSize(spirv, operands[0]);
+            return stride * length;
+        }
+        case Spirv::OpTypeStruct:
+        {
+            u32 size = 0;
+            for (const auto [member, memberType] : std::views::enumerate(operands))
+            {
+                const auto key = MemberKey(typeId, static_cast<u32>(member));
+                const auto offsetIt = spirv.memberOffsets.find(key);
+                const auto offset =
+                    offsetIt != spirv.memberOffsets.end() ? offsetIt->second : size;
+                const auto strideIt = spirv.matrixStrides.find(key);
+                const auto stride =
+                    strideIt != spirv.matrixStrides.end() ? strideIt->second : 0;
+                size = std::max(size, offset + GetSpirvTypeSize(spirv, memberType, stride));
+            }
+            return size;
+        }
+        case Spirv::OpTypePointer:
+            // Buffer device addresses
+            return 8;
+        default:
+            return 0;
+        }
+    }
+} // namespace
 
 namespace Swift::Vulkan
 {
@@ -11,7 +142,6 @@ namespace Swift::Vulkan
         const vk::PhysicalDevice physicalDevice,
         const vk::SurfaceKHR surface)
     {
-        std::vector<u32> indices;
         std::optional<u32> graphicsFamily;
         std::optional<u32> computeFamily;
         std::optional<u32> transferFamily;
@@ -20,28 +150,33 @@ namespace Swift::Vulkan
         {
             if (family.queueFlags & vk::QueueFlagBits::eGraphics && !graphicsFamily.has_value())
             {
-                [[maybe_unused]] const auto [result, support] =
-                    physicalDevice.getSurfaceSupportKHR(index, surface);
-                VK_ASSERT(result, "Failed to get surface for queue family");
+                if (surface)
+                {
+                    [[maybe_unused]] const auto [result, support] =
+                        physicalDevice.getSurfaceSupportKHR(index, surface);
+                    VK_ASSERT(result, "Failed to get surface for queue family");
+                }
                 graphicsFamily = static_cast<u32>(index);
-                indices.emplace_back(static_cast<u32>(index));
                 continue;
             }
 
             if (family.queueFlags & vk::QueueFlagBits::eCompute && !computeFamily.has_value())
             {
                 computeFamily = static_cast<u32>(index);
-                indices.emplace_back(static_cast<u32>(index));
                 continue;
             }
 
             if (family.queueFlags & vk::QueueFlagBits::eTransfer && !transferFamily.has_value())
             {
                 transferFamily = static_cast<u32>(index);
-                indices.emplace_back(static_cast<u32>(index));
             }
         }
-        return indices;
+        assert(graphicsFamily.has_value() && "No graphics queue family found");
+        // Fall back to the graphics family on devices without dedicated queues (e.g. lavapipe)
+        return {
+            graphicsFamily.value(),
+            computeFamily.value_or(graphicsFamily.value()),
+            transferFamily.value_or(graphicsFamily.value())};
     }
 
     vk::Extent3D Util::GetMipExtent(
@@ -63,32 +198,39 @@ namespace Swift::Vulkan
         return {mipWidth, mipHeight};
     }
 
-    void Util::HandleSubOptimalSwapchain(
+    Swapchain Util::RecreateSwapchain(
         const u32 graphicsFamily,
         const Context& context,
         Swapchain& swapchain,
         const vk::Extent2D extent)
     {
-        [[maybe_unused]]
-        const auto result = context.device.waitIdle();
-        VK_ASSERT(result, "Failed to wait for device while cleaning up");
-        swapchain.Destroy(context);
+        const auto oldSwapchain = swapchain;
+        const auto swapchainExtent = GetSwapchainExtent(context.gpu, context.surface, extent);
 
         constexpr auto depthFormat = vk::Format::eD32Sfloat;
         const auto depthImage = Init::CreateImage(
             context,
             vk::ImageType::e2D,
-            vk::Extent3D(extent, 1),
+            vk::Extent3D(swapchainExtent, 1),
             depthFormat,
-            vk::ImageUsageFlagBits::eDepthStencilAttachment,
+            vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                vk::ImageUsageFlagBits::eTransferSrc,
             1,
             {},
             "Swapchain Depth");
 
-        swapchain.SetSwapchain(Init::CreateSwapchain(context, extent, graphicsFamily))
+        swapchain
+            .SetSwapchain(
+                Init::CreateSwapchain(
+                    context,
+                    swapchainExtent,
+                    graphicsFamily,
+                    oldSwapchain.swapchain))
             .SetDepthImage(depthImage)
             .SetImages(Init::CreateSwapchainImages(context, swapchain))
-            .SetExtent(extent);
+            .SetExtent(swapchainExtent);
+        swapchain.bRecreate = false;
+        return oldSwapchain;
     }
 
     void Util::SubmitQueue(
@@ -115,6 +257,29 @@ namespace Swift::Vulkan
         VK_ASSERT(result, "Failed to submit queue");
     }
 
+    void Util::SubmitQueue(
+        const vk::Queue queue,
+        const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+        const vk::ArrayProxy<const vk::SemaphoreSubmitInfo> waitInfos,
+        const vk::ArrayProxy<const vk::SemaphoreSubmitInfo> signalInfos,
+        const vk::Fence fence)
+    {
+        std::vector<vk::CommandBufferSubmitInfo> commandInfos;
+        commandInfos.reserve(commandBuffers.size());
+        for (const auto commandBuffer : commandBuffers)
+        {
+            commandInfos.emplace_back(
+                vk::CommandBufferSubmitInfo().setDeviceMask(1).setCommandBuffer(commandBuffer));
+        }
+        const auto submitInfo = vk::SubmitInfo2()
+                                    .setCommandBufferInfos(commandInfos)
+                                    .setWaitSemaphoreInfos(waitInfos)
+                                    .setSignalSemaphoreInfos(signalInfos);
+        [[maybe_unused]]
+        const auto result = queue.submit2(submitInfo, fence);
+        VK_ASSERT(result, "Failed to submit queue");
+    }
+
     void Util::SubmitQueueHost(
         const vk::Queue queue,
         const vk::CommandBuffer commandBuffer,
@@ -171,13 +336,50 @@ namespace Swift::Vulkan
         device.updateDescriptorSets(samplerWriteInfo, {});
     }
 
+    void Util::UpdateDescriptorSamplers(
+        const vk::DescriptorSet set,
+        const std::span<const vk::ImageView> imageViews,
+        const std::span<const u32> arrayElements,
+        const vk::Sampler sampler,
+        const vk::Device& device)
+    {
+        assert(imageViews.size() == arrayElements.size());
+        std::vector<vk::DescriptorImageInfo> imageInfos;
+        imageInfos.reserve(imageViews.size());
+        for (const auto imageView : imageViews)
+        {
+            imageInfos.emplace_back(vk::DescriptorImageInfo()
+                                        .setImageLayout(vk::ImageLayout::eGeneral)
+                                        .setImageView(imageView)
+                                        .setSampler(sampler));
+        }
+        // Array elements are not guaranteed to be contiguous, so each image gets its own write
+        std::vector<vk::WriteDescriptorSet> samplerWriteInfos;
+        samplerWriteInfos.reserve(imageViews.size());
+        for (u32 i = 0; i < imageInfos.size(); i++)
+        {
+            samplerWriteInfos.emplace_back(
+                vk::WriteDescriptorSet()
+                    .setDstSet(set)
+                    .setDstBinding(Constants::SamplerBinding)
+                    .setDstArrayElement(arrayElements[i])
+                    .setDescriptorCount(1)
+                    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                    .setImageInfo(imageInfos[i]));
+        }
+        device.updateDescriptorSets(samplerWriteInfos, {});
+    }
+
     vk::ImageMemoryBarrier2 Util::ImageBarrier(
         const vk::ImageLayout oldLayout,
         const vk::ImageLayout newLayout,
         Image& image,
         const vk::ImageAspectFlags flags,
         const u32 mipCount,
-        const u32 arrayLayers)
+        const u32 arrayLayers,
+        const u32 srcQueueFamily,
+        const u32 dstQueueFamily,
+        const u32 baseMip)
     {
         const auto imageBarrier =
             vk::ImageMemoryBarrier2()
@@ -188,21 +390,57 @@ namespace Swift::Vulkan
                 .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
                 .setOldLayout(oldLayout)
                 .setNewLayout(newLayout)
-                .setSubresourceRange(GetImageSubresourceRange(flags, mipCount, 0, arrayLayers))
+                .setSubresourceRange(
+                    GetImageSubresourceRange(flags, mipCount, baseMip, arrayLayers))
+                .setSrcQueueFamilyIndex(srcQueueFamily)
+                .setDstQueueFamilyIndex(dstQueueFamily)
                 .setImage(image);
         image.currentLayout = newLayout;
         return imageBarrier;
     }
 
     void Util::PipelineBarrier(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         vk::ArrayProxy<vk::ImageMemoryBarrier2> imageBarriers)
     {
         const auto dependency = vk::DependencyInfo().setImageMemoryBarriers(imageBarriers);
-        commandBuffer.pipelineBarrier2(dependency);
+        commandBuffer.pipelineBarrier2(dependency, context.dynamicLoader);
+    }
+
+    vk::BufferMemoryBarrier2 Util::BufferBarrier(
+        const vk::Buffer buffer,
+        const vk::DeviceSize offset,
+        const vk::DeviceSize size,
+        const u32 srcQueueFamily,
+        const u32 dstQueueFamily)
+    {
+        const auto bufferBarrier =
+            vk::BufferMemoryBarrier2()
+                .setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+                .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setDstAccessMask(
+                    vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+                .setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+                .setSrcQueueFamilyIndex(srcQueueFamily)
+                .setDstQueueFamilyIndex(dstQueueFamily)
+                .setBuffer(buffer)
+                .setOffset(offset)
+                .setSize(size);
+        return bufferBarrier;
+    }
+
+    void Util::PipelineBarrier(
+        const Context& context,
+        const vk::CommandBuffer commandBuffer,
+        vk::ArrayProxy<vk::BufferMemoryBarrier2> bufferBarriers)
+    {
+        const auto dependency = vk::DependencyInfo().setBufferMemoryBarriers(bufferBarriers);
+        commandBuffer.pipelineBarrier2(dependency, context.dynamicLoader);
     }
 
     void Util::ClearColorImage(
+        const Context& context,
         const vk::CommandBuffer& commandBuffer,
         const Image& image,
         const vk::ClearColorValue& clearColor)
@@ -211,7 +449,133 @@ namespace Swift::Vulkan
             image,
             image.currentLayout,
             vk::ClearColorValue(clearColor),
-            GetImageSubresourceRange(vk::ImageAspectFlagBits::eColor));
+            GetImageSubresourceRange(vk::ImageAspectFlagBits::eColor),
+            context.dynamicLoader);
+    }
+
+    u32 Util::ReflectPushConstantSize(const std::span<const char> code)
+    {
+        std::vector<u32> words(code.size() / sizeof(u32));
+        std::memcpy(words.data(), code.data(), words.size() * sizeof(u32));
+        if (words.size() < Spirv::HeaderWords || words[0] != Spirv::Magic)
+        {
+            assert(false && "Invalid SPIR-V module");
+            return 0;
+        }
+
+        SpirvModule spirv;
+        for (auto index = Spirv::HeaderWords; index < words.size();)
+        {
+            const auto wordCount = words[index] >> 16;
+            const auto opcode = words[index] & 0xFFFF;
+            if (wordCount == 0 || index + wordCount > words.size())
+            {
+                break;
+            }
+            const auto instruction = std::span(words).subspan(index, wordCount);
+            index += wordCount;
+
+            switch (opcode)
+            {
+            case Spirv::OpTypeBool:
+            case Spirv::OpTypeInt:
+            case Spirv::OpTypeFloat:
+            case Spirv::OpTypeVector:
+            case Spirv::OpTypeMatrix:
+            case Spirv::OpTypeArray:
+            case Spirv::OpTypeStruct:
+            case Spirv::OpTypePointer:
+            {
+                const auto operands = instruction.subspan(2);
+                spirv.types[instruction[1]] = {opcode, {operands.begin(), operands.end()}};
+                break;
+            }
+            case Spirv::OpConstant:
+                spirv.constants[instruction[2]] = instruction[3];
+                break;
+            case Spirv::OpVariable:
+                if (instruction[3] == Spirv::StorageClassPushConstant)
+                {
+                    spirv.pushConstantPointer = instruction[1];
+                }
+                break;
+            case Spirv::OpDecorate:
+                if (instruction[2] == Spirv::DecorationArrayStride)
+                {
+                    spirv.arrayStrides[instruction[1]] = instruction[3];
+                }
+                break;
+            case Spirv::OpMemberDecorate:
+            {
+                const auto key = MemberKey(instruction[1], instruction[2]);
+                if (instruction[3] == Spirv::DecorationOffset)
+                {
+                    spirv.memberOffsets[key] = instruction[4];
+                }
+                else if (instruction[3] == Spirv::DecorationMatrixStride)
+                {
+                    spirv.matrixStrides[key] = instruction[4];
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        const auto pointerIt = spirv.types.find(spirv.pushConstantPointer);
+        if (pointerIt == spirv.types.end())
+        {
+            return 0;
+        }
+        // Pointer operands are the storage class followed by the pointee
+        const auto size = GetSpirvTypeSize(spirv, pointerIt->second.operands[1]);
+        return PadAlignment(size, 4);
+    }
+
+    vk::PushConstantRange Util::ReflectGraphicsPushConstantRange(
+        const std::span<const char> vertexCode,
+        const std::span<const char> fragmentCode)
+    {
+        const auto vertexPushSize = ReflectPushConstantSize(vertexCode);
+        const auto fragmentPushSize = ReflectPushConstantSize(fragmentCode);
+        vk::ShaderStageFlags pushStageFlags;
+        if (vertexPushSize > 0)
+        {
+            pushStageFlags |= vk::ShaderStageFlagBits::eVertex;
+        }
+        if (fragmentPushSize > 0)
+        {
+            pushStageFlags |= vk::ShaderStageFlagBits::eFragment;
+        }
+        return vk::PushConstantRange()
+            .setSize(std::max(vertexPushSize, fragmentPushSize))
+            .setStageFlags(pushStageFlags);
+    }
+
+    vk::PushConstantRange Util::ReflectComputePushConstantRange(
+        const std::span<const char> computeCode)
+    {
+        return vk::PushConstantRange()
+            .setSize(ReflectPushConstantSize(computeCode))
+            .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    }
+
+    void Util::SavePipelineCache(
+        const Context& context,
+        const std::string_view filePath)
+    {
+        const auto [result, data] = context.device.getPipelineCacheData(context.pipelineCache);
+        VK_ASSERT(result, "Failed to get pipeline cache data");
+        if (result != vk::Result::eSuccess || data.empty())
+        {
+            return;
+        }
+        [[maybe_unused]]
+        const auto written = FileIO::WriteBinaryFile(
+            filePath,
+            std::span(reinterpret_cast<const char*>(data.data()), data.size()));
+        assert(written && "Failed to write pipeline cache");
     }
 
     void* Util::MapBuffer(
@@ -236,14 +600,17 @@ namespace Swift::Vulkan
         const Context& context,
         const vk::CommandBuffer commandBuffer,
         const u32 queueIndex,
-        const dds::Header& ddsImage,
-        const std::string_view filePath,
+        const DDS::Header& ddsImage,
+        const MappedFile& file,
         const u32 mipLevel,
         const bool loadAllMips,
-        const Image& image)
+        const Image& image,
+        StagingRing& stagingRing,
+        const u64 ticket,
+        const u32 dstBaseMip)
     {
-        u32 start;
-        u32 imageSize;
+        u64 start;
+        u64 imageSize;
         if (loadAllMips)
         {
             start = ddsImage.MipOffset(mipLevel);
@@ -265,44 +632,72 @@ namespace Swift::Vulkan
             }
         }
 
-        const auto buffer = Init::CreateBuffer(
-            context,
-            queueIndex,
-            imageSize,
-            vk::BufferUsageFlagBits::eTransferSrc,
-            false,
-            "Staging");
+        // Only uploads that don't fit in the ring get a dedicated staging buffer, which is returned
+        // so the caller can destroy it once the transfer is done
+        Buffer dedicatedBuffer;
+        vk::Buffer srcBuffer;
+        vk::DeviceSize srcOffset = 0;
+        char* mapped;
+        if (const auto offset = stagingRing.Allocate(imageSize, 16, ticket))
+        {
+            srcBuffer = stagingRing.buffer;
+            srcOffset = offset.value();
+            mapped = static_cast<char*>(stagingRing.mapped) + srcOffset;
+        }
+        else
+        {
+            dedicatedBuffer = Init::CreateBuffer(
+                context,
+                queueIndex,
+                imageSize,
+                vk::BufferUsageFlagBits::eTransferSrc,
+                false,
+                "Staging");
+            srcBuffer = dedicatedBuffer;
+            mapped = static_cast<char*>(MapBuffer(context, dedicatedBuffer));
+        }
 
-        std::ifstream file((filePath.data()), std::ios::binary);
-        file.seekg(start, std::ios::beg);
+        assert(start + imageSize <= file.size && "DDS payload is truncated");
+        std::memcpy(mapped, file.data + start, imageSize);
 
-        const auto mapped = MapBuffer(context, buffer);
-        file.read(static_cast<char*>(mapped), imageSize);
-        UnmapBuffer(context, buffer);
+        if (dedicatedBuffer.buffer)
+        {
+            UnmapBuffer(context, dedicatedBuffer);
+        }
+        else
+        {
+            vmaFlushAllocation(context.allocator, stagingRing.buffer.allocation, srcOffset, imageSize);
+        }
 
         CopyBufferToImage(
+            context,
             commandBuffer,
-            buffer,
+            srcBuffer,
+            srcOffset,
             ddsImage,
             mipLevel,
             loadAllMips,
-            image);
-        return buffer;
+            image,
+            dstBaseMip);
+        return dedicatedBuffer;
     }
 
     void Util::CopyBufferToImage(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         const vk::Buffer buffer,
-        const dds::Header& ddsImage,
+        const vk::DeviceSize bufferOffset,
+        const DDS::Header& ddsImage,
         const u32 maxMipLevel,
         const bool loadAllMips,
-        const vk::Image image)
+        const vk::Image image,
+        const u32 dstBaseMip)
     {
         std::vector<vk::BufferImageCopy2> copyRegions;
         if (loadAllMips)
         {
             const auto extent = ddsImage.GetVulkanExtent();
-            u32 offset = 0;
+            vk::DeviceSize offset = bufferOffset;
             for (u32 layer = 0; layer < ddsImage.ArraySize(); layer++)
             {
                 for (int i = maxMipLevel; i < ddsImage.MipLevels(); i++)
@@ -317,7 +712,7 @@ namespace Swift::Vulkan
                                                      .setImageExtent(mipExtent)
                                                      .setImageSubresource(GetImageSubresourceLayers(
                                                          vk::ImageAspectFlagBits::eColor,
-                                                         i - maxMipLevel,
+                                                         dstBaseMip + i - maxMipLevel,
                                                          1,
                                                          layer))
                                                      .setBufferOffset(offset);
@@ -332,8 +727,15 @@ namespace Swift::Vulkan
             {
                 const auto extent = Util::GetMipExtent(ddsImage.GetVulkanExtent(), maxMipLevel);
                 const auto bufferImageCopy =
-                    vk::BufferImageCopy2().setImageExtent(extent).setImageSubresource(
-                        GetImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 1, i));
+                    vk::BufferImageCopy2()
+                        .setImageExtent(extent)
+                        .setImageSubresource(
+                            GetImageSubresourceLayers(
+                                vk::ImageAspectFlagBits::eColor,
+                                dstBaseMip,
+                                1,
+                                i))
+                        .setBufferOffset(bufferOffset);
                 copyRegions.emplace_back(bufferImageCopy);
             }
         }
@@ -342,10 +744,11 @@ namespace Swift::Vulkan
                                            .setDstImage(image)
                                            .setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
                                            .setRegions(copyRegions);
-        commandBuffer.copyBufferToImage2(bufferToImageInfo);
+        commandBuffer.copyBufferToImage2(bufferToImageInfo, context.dynamicLoader);
     }
 
     void Util::CopyImage(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         const vk::Image srcImage,
         const vk::ImageLayout srcLayout,
@@ -366,10 +769,11 @@ namespace Swift::Vulkan
                                        .setDstImage(dstImage)
                                        .setDstImageLayout(dstLayout)
                                        .setRegions(copyRegion);
-        commandBuffer.copyImage2(copyImageInfo);
+        commandBuffer.copyImage2(copyImageInfo, context.dynamicLoader);
     }
 
     void Util::BlitImage(
+        const Context& context,
         const vk::CommandBuffer commandBuffer,
         const vk::Image srcImage,
         const vk::ImageLayout srcLayout,
@@ -403,6 +807,6 @@ namespace Swift::Vulkan
                                   .setDstImageLayout(dstLayout)
                                   .setRegions(blitRegion)
                                   .setFilter(vk::Filter::eLinear);
-        commandBuffer.blitImage2(blitInfo);
+        commandBuffer.blitImage2(blitInfo, context.dynamicLoader);
     }
 } // namespace Swift::Vulkan
\ No newline at end of file